@@ -0,0 +1,191 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file examples/camera_example/projection_check.cc
+    \brief Client-side projection check implementation
+
+    Checks that CameraProjector matches the projections computed by the
+    CameraUtils plugin, for several camera poses
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "projection_check.hh"
+
+/// Synchronizes client with plugin responses
+Synchronizer g_sync;
+/// Guards latest responses
+std::mutex g_mutex;
+/// Latest camera intrinsics response
+gap::msgs::CameraUtilsResponse g_info;
+/// Latest point projection response
+gap::msgs::CameraUtilsResponse g_projection;
+
+//////////////////////////////////////////////////
+int main(int _argc, char **_argv)
+{
+    // Load gazebo as a client
+    gazebo::client::setup(_argc, _argv);
+
+    // Create the communication node
+    gazebo::transport::NodePtr node(new gazebo::transport::Node());
+    node->Init();
+
+    // Publish to camera utils topic and subscribe to its replies
+    gazebo::transport::PublisherPtr pub =
+        node->Advertise<gap::msgs::CameraUtilsRequest>(CAMERA_UTILS_TOPIC);
+    gazebo::transport::SubscriberPtr sub =
+        node->Subscribe(CAMERA_UTILS_RESPONSE_TOPIC, onCameraUtilsResponse);
+
+    // Wait for a subscriber to connect to this publisher
+    pub->WaitForConnection();
+
+    // Build projector from plugin intrinsics
+    gap::msgs::CameraUtilsRequest msg;
+    msg.set_type(INFO_REQUEST);
+    g_sync.clear(INFO_RESPONSE);
+    pub->Publish(msg);
+    if (!g_sync.wait(INFO_RESPONSE, Synchronizer::ANY, TIMEOUT)) {
+        std::cerr << "Timed out waiting for camera info" << std::endl;
+        gazebo::client::shutdown();
+        return EXIT_FAILURE;
+    }
+    gap::msgs::CameraInfo info;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        info = g_info.info();
+    }
+    CameraProjector projector(info);
+
+    int mismatches = 0;
+    for (int i = 0; i < POSES; i++) {
+        mismatches += checkPose(pub, projector, cameraPose(i));
+    }
+
+    gazebo::client::shutdown();
+
+    if (mismatches) {
+        std::cerr << mismatches << " points projected differently"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Projections match for " << POSES << " camera poses"
+        << std::endl;
+    return EXIT_SUCCESS;
+}
+
+//////////////////////////////////////////////////
+void onCameraUtilsResponse(CameraUtilsResponsePtr &_msg)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (_msg->type() == INFO_RESPONSE) {
+            g_info = *_msg;
+        } else if (_msg->type() == PROJECTION_RESPONSE) {
+            g_projection = *_msg;
+        }
+    }
+    g_sync.notify(_msg->type());
+}
+
+//////////////////////////////////////////////////
+ignition::math::Pose3d cameraPose(const int i)
+{
+    return ignition::math::Pose3d(
+        0.5 * i - 1.0, 0.25 * i, 0.5 + 0.3 * i,
+        0.1 * i, 0.15 * i, 0.8 * i);
+}
+
+//////////////////////////////////////////////////
+int checkPose(
+    gazebo::transport::PublisherPtr _pub,
+    CameraProjector & _projector,
+    const ignition::math::Pose3d & _pose)
+{
+    gap::msgs::CameraUtilsRequest msg;
+    msg.set_type(MOVE_REQUEST);
+    gazebo::msgs::Set(msg.mutable_pose(), _pose);
+    g_sync.clear(MOVE_RESPONSE);
+    _pub->Publish(msg);
+    if (!g_sync.wait(MOVE_RESPONSE, Synchronizer::ANY, TIMEOUT)) {
+        std::cerr << "Timed out moving camera" << std::endl;
+        return GRID * GRID * GRID;
+    }
+
+    // Sample points in camera frame, spanning and exceeding the
+    // field of view at several depths
+    msg.Clear();
+    msg.set_type(PROJECTION_REQUEST);
+    gap::msgs::PointProjection *proj = msg.add_projections();
+    const double half = GRID / 2;
+    for (int d = 0; d < GRID; d++)
+    {
+        const double depth = 0.5 + d;
+        for (int h = 0; h < GRID; h++) {
+            for (int v = 0; v < GRID; v++)
+            {
+                const ignition::math::Vector3d local(
+                    depth, depth * (h - half) / half, depth * (v - half) / half);
+                gazebo::msgs::Set(proj->add_point3(),
+                    _pose.Pos() + _pose.Rot().RotateVector(local));
+            }
+        }
+    }
+    g_sync.clear(PROJECTION_RESPONSE);
+    _pub->Publish(msg);
+    if (!g_sync.wait(PROJECTION_RESPONSE, Synchronizer::ANY, TIMEOUT)) {
+        std::cerr << "Timed out waiting for projections" << std::endl;
+        return GRID * GRID * GRID;
+    }
+    gap::msgs::CameraUtilsResponse response;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        response = g_projection;
+    }
+
+    // Project with the pose reported by the plugin, as it already holds
+    // any rounding of the requested one
+    _projector.setPose(gazebo::msgs::ConvertIgn(response.pose()));
+
+    if (response.projections_size() != 1 ||
+        response.projections(0).point2_size() != proj->point3_size())
+    {
+        std::cerr << "Unexpected projection response" << std::endl;
+        return GRID * GRID * GRID;
+    }
+
+    // Plugin replies with pixels only, in the order of requested points
+    int mismatches = 0;
+    const gap::msgs::PointProjection & result = response.projections(0);
+    for (int i = 0; i < result.point2_size(); i++)
+    {
+        ignition::math::Vector3d point3 =
+            gazebo::msgs::ConvertIgn(proj->point3(i));
+        ignition::math::Vector2i expected(
+            result.point2(i).x(), result.point2(i).y());
+        ignition::math::Vector2i actual = _projector.project(point3);
+        if (actual != expected)
+        {
+            if (mismatches++ < 10) {
+                std::cerr << "Pose [" << _pose << "] point [" << point3
+                    << "]: plugin " << expected << ", client " << actual
+                    << std::endl;
+            }
+        }
+    }
+    return mismatches;
+}
@@ -0,0 +1,95 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file examples/camera_example/projection_check.hh
+    \brief Client-side projection check
+
+    Checks that CameraProjector matches the projections computed by the
+    CameraUtils plugin, for several camera poses
+
+    \author João Borrego : jsbruglie
+*/
+
+// Gazebo
+#include <gazebo/gazebo_client.hh>
+#include <gazebo/gazebo_config.h>
+#include <gazebo/transport/transport.hh>
+#include <gazebo/msgs/msgs.hh>
+
+// I/O streams
+#include <iostream>
+// Mutex
+#include <mutex>
+
+// Custom messages
+#include "camera_utils_request.pb.h"
+#include "camera_utils_response.pb.h"
+// Client-side projection
+#include "CameraProjector.hh"
+// Wait for plugin responses
+#include "Synchronizer.hh"
+
+/// Request to move camera
+#define MOVE_REQUEST        gap::msgs::CameraUtilsRequest::MOVE
+/// Request to project points
+#define PROJECTION_REQUEST  gap::msgs::CameraUtilsRequest::PROJECTION
+/// Request camera intrinsics
+#define INFO_REQUEST        gap::msgs::CameraUtilsRequest::INFO
+/// Camera moved response
+#define MOVE_RESPONSE       gap::msgs::CameraUtilsResponse::MOVE
+/// Projected points response
+#define PROJECTION_RESPONSE gap::msgs::CameraUtilsResponse::PROJECTION
+/// Camera intrinsics response
+#define INFO_RESPONSE       gap::msgs::CameraUtilsResponse::INFO
+
+/// Topic monitored by the server for incoming commands
+#define CAMERA_UTILS_TOPIC          "~/gap/camera_utils"
+/// Topic for receiving replies from the server
+#define CAMERA_UTILS_RESPONSE_TOPIC "~/gap/camera_utils/response"
+
+/// Maximum time to wait for each response, in seconds
+#define TIMEOUT         5.0
+/// Number of camera poses checked
+#define POSES           8
+/// Number of sampled points per axis, in camera frame
+#define GRID            9
+
+/// Response message pointer typedef
+typedef const boost::shared_ptr<const gap::msgs::CameraUtilsResponse>
+    CameraUtilsResponsePtr;
+
+/// \brief Callback for CameraUtils responses
+/// \param _msg Response message
+void onCameraUtilsResponse(CameraUtilsResponsePtr & _msg);
+
+/// \brief Obtains the i-th checked camera pose
+///
+/// Poses sweep position, yaw, pitch and roll, so that every rotation
+/// component takes part in the view matrix
+/// \param i    Pose index
+/// \return Camera world pose
+ignition::math::Pose3d cameraPose(const int i);
+
+/// \brief Checks projection of sampled points for a camera pose
+/// \param _pub         Camera utils request publisher
+/// \param _projector   Client-side projector
+/// \param _pose        Camera world pose
+/// \return Number of points projected to different pixels
+int checkPose(
+    gazebo::transport::PublisherPtr _pub,
+    CameraProjector & _projector,
+    const ignition::math::Pose3d & _pose);
@@ -35,9 +35,9 @@ int main(int _argc, char **_argv)
         // Obtain full names
         visuals.at(i) = model + "::" + visuals.at(i); 
     }
-    std::string parent("shadowhand");
     int pid_type = DRInterface::POSITION;
     double inf = INFINITY;
+    Philox rng(std::random_device{}());
 
     // Disable gravity
     interface.addGravity(msg, Vector3d(0,0,0));
@@ -52,22 +52,22 @@ int main(int _argc, char **_argv)
     // Blocking publish call 
     interface.publish(msg, true);
     
-    // Update link colors
+    // Update link colors, every link in a single batched request
     for (int i = 0; i < 20; i++)
     {
+        VisualUtilsRequest color_msg;
         for (auto const visual : visuals)
         {
-            gazebo::msgs::Visual color_msg;
-            double r = getRandomDouble(0,1);
-            double g = getRandomDouble(0,1);
-            double b = getRandomDouble(0,1);
-            interface.addColors(color_msg, visual, parent,
+            double r = uniformReal(rng, 0, 1);
+            double g = uniformReal(rng, 0, 1);
+            double b = uniformReal(rng, 0, 1);
+            interface.addColors(color_msg, visual,
                 Color(r, g, b),
                 Color(r, g, b),
                 Color(0.1, 0,    0.1),
                 Color(0.2, 0.2,  0.2, 64));
-            interface.publish(color_msg);
         }
+        interface.publish(color_msg);
         waitMs(500);
     }
 
@@ -76,27 +76,6 @@ int main(int _argc, char **_argv)
     return 0;
 }
 
-//////////////////////////////////////////////////
-
-// Random integer generator
-std::random_device rng;
-std::mt19937 mt_rng(rng());
-std::uniform_int_distribution<int> uniform_dist;
-
-//////////////////////////////////////////////////
-int getRandomInt(int min, int max)
-{
-    int aux = uniform_dist(mt_rng);
-    return aux % (max - min + 1) + min;;
-}
-
-//////////////////////////////////////////////////
-double getRandomDouble(double min, double max)
-{
-    double aux = ((double) uniform_dist(mt_rng)) / (double) RAND_MAX;
-    return aux * (max - min) + min;
-}
-
 /////////////////////////////////////////////////
 void inline waitMs(int delay)
 {
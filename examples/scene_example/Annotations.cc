@@ -0,0 +1,239 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file examples/scene_example/Annotations.cc
+    \brief Scene annotation records and their output formats implementation
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "Annotations.hh"
+
+#include <cstdint>
+#include <cstring>
+
+//////////////////////////////////////////////////
+
+// Binary serialization helpers
+
+/// \brief Appends raw value to record
+template <typename T>
+static void put(std::string & record, const T value)
+{
+    record.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+/// \brief Appends length-prefixed string to record
+static void putString(std::string & record, const std::string & value)
+{
+    uint16_t size = std::min<std::size_t>(value.size(), UINT16_MAX);
+    put(record, size);
+    record.append(value, 0, size);
+}
+
+/// \brief Appends pose to record, as position and quaternion
+static void putPose(std::string & record, const ignition::math::Pose3d & pose)
+{
+    const double values[7] = {
+        pose.Pos().X(), pose.Pos().Y(), pose.Pos().Z(),
+        pose.Rot().W(), pose.Rot().X(), pose.Rot().Y(), pose.Rot().Z()};
+    record.append(reinterpret_cast<const char *>(values), sizeof(values));
+}
+
+/// \brief Reads raw value from stream
+template <typename T>
+static bool get(std::istream & in, T & value)
+{
+    return !!in.read(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+/// \brief Reads length-prefixed string from stream
+static bool getString(std::istream & in, std::string & value)
+{
+    uint16_t size;
+    if (!get(in, size)) {
+        return false;
+    }
+    value.resize(size);
+    return size == 0 || !!in.read(&value[0], size);
+}
+
+/// \brief Reads pose from stream
+static bool getPose(std::istream & in, ignition::math::Pose3d & pose)
+{
+    double values[7];
+    if (!in.read(reinterpret_cast<char *>(values), sizeof(values))) {
+        return false;
+    }
+    pose.Set(ignition::math::Vector3d(values[0], values[1], values[2]),
+        ignition::math::Quaterniond(values[3], values[4], values[5], values[6]));
+    return true;
+}
+
+//////////////////////////////////////////////////
+void writeVOC(std::ostream & out, const SceneAnnotation & annotation)
+{
+    const unsigned int iteration = annotation.iteration;
+    std::string image_name = std::to_string(iteration / 100) + "00/" +
+        std::to_string(iteration) + ".png";
+
+    out << "<annotation>\n"
+        << "  <folder>images</folder>\n"
+        << "  <filename>" + image_name + "</filename>\n"
+        << "  <source>\n"
+        << "    <database>The SHAPE2018 Database</database>\n"
+        << "    <annotation>SHAPE SHAPE2018</annotation>\n"
+        << "    <image>" << image_name <<"</image>\n"
+        << "    <pose>" << annotation.camera_pose <<"</pose>\n"
+        << "  </source>\n"
+        << "  <size>\n"
+        << "    <width>"  << annotation.width  << "</width>\n"
+        << "    <height>" << annotation.height << "</height>\n"
+        << "    <depth>"  << annotation.depth  << "</depth>\n"
+        << "  </size>\n"
+        << "  <segmented>1</segmented>\n";
+
+    for (const auto & object : annotation.objects)
+    {
+        out << "  <object>\n"
+            << "    <name>" << object.name << "</name>\n"
+            << "    <pose>" << object.pose << "</pose>\n"
+            << "    <material>" << object.material << "</material>\n"
+            << "    <truncated>0</truncated>\n"
+            << "    <difficult>1</difficult>\n"
+            << "    <bndbox>\n"
+            << "      <xmin>"<< object.bounding_box[0] <<"</xmin>\n"
+            << "      <ymin>"<< object.bounding_box[1] <<"</ymin>\n"
+            << "      <xmax>"<< object.bounding_box[2] <<"</xmax>\n"
+            << "      <ymax>"<< object.bounding_box[3] <<"</ymax>\n"
+            << "    </bndbox>\n"
+            << "  </object>\n";
+    }
+
+    out << "</annotation>";
+}
+
+//////////////////////////////////////////////////
+BinaryAnnotationWriter::BinaryAnnotationWriter(const std::string & _dir):
+    dir(_dir), buffer(new char[ANNOTATIONS_BUFFER])
+{
+}
+
+//////////////////////////////////////////////////
+bool BinaryAnnotationWriter::write(const SceneAnnotation & annotation)
+{
+    if ((!out.is_open() || count == ANNOTATIONS_PER_FILE) &&
+        !open(annotation.iteration)) {
+        return false;
+    }
+
+    // Serialize whole record, then write it at once
+    record.clear();
+    put<uint32_t>(record, annotation.iteration);
+    putPose(record, annotation.camera_pose);
+    put<uint32_t>(record, annotation.width);
+    put<uint32_t>(record, annotation.height);
+    put<uint32_t>(record, annotation.depth);
+    put<uint32_t>(record, annotation.objects.size());
+    for (const auto & object : annotation.objects)
+    {
+        putString(record, object.name);
+        putPose(record, object.pose);
+        for (int i = 0; i < 4; i++) {
+            put<int32_t>(record, object.bounding_box[i]);
+        }
+        putString(record, object.material);
+    }
+
+    out.write(record.data(), record.size());
+    count++;
+    return !!out;
+}
+
+//////////////////////////////////////////////////
+bool BinaryAnnotationWriter::open(const unsigned int iteration)
+{
+    // Buffer must be set before the first file is opened
+    if (out.is_open()) {
+        out.close();
+    } else {
+        out.rdbuf()->pubsetbuf(buffer.get(), ANNOTATIONS_BUFFER);
+    }
+
+    std::string path = dir + "/" + std::to_string(iteration) + ANNOTATIONS_EXT;
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+
+    out.write(ANNOTATIONS_MAGIC, strlen(ANNOTATIONS_MAGIC));
+    uint32_t version = ANNOTATIONS_VERSION;
+    out.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    count = 0;
+    return !!out;
+}
+
+//////////////////////////////////////////////////
+BinaryAnnotationReader::BinaryAnnotationReader(const std::string & path):
+    in(path, std::ios::binary)
+{
+    char magic[sizeof(ANNOTATIONS_MAGIC) - 1];
+    uint32_t version;
+    ok = in.read(magic, sizeof(magic)) &&
+        !strncmp(magic, ANNOTATIONS_MAGIC, sizeof(magic)) &&
+        get(in, version) && version == ANNOTATIONS_VERSION;
+}
+
+//////////////////////////////////////////////////
+bool BinaryAnnotationReader::valid() const
+{
+    return ok;
+}
+
+//////////////////////////////////////////////////
+bool BinaryAnnotationReader::read(SceneAnnotation & annotation)
+{
+    if (!ok) {
+        return false;
+    }
+
+    uint32_t iteration, width, height, depth, objects;
+    if (!get(in, iteration) || !getPose(in, annotation.camera_pose) ||
+        !get(in, width) || !get(in, height) || !get(in, depth) ||
+        !get(in, objects)) {
+        return false;
+    }
+    annotation.iteration = iteration;
+    annotation.width = width;
+    annotation.height = height;
+    annotation.depth = depth;
+    annotation.objects.resize(objects);
+
+    for (auto & object : annotation.objects)
+    {
+        int32_t box[4];
+        if (!getString(in, object.name) || !getPose(in, object.pose) ||
+            !in.read(reinterpret_cast<char *>(box), sizeof(box)) ||
+            !getString(in, object.material)) {
+            return false;
+        }
+        std::copy(box, box + 4, object.bounding_box);
+    }
+    return true;
+}
@@ -0,0 +1,156 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file examples/scene_example/Annotations.hh
+    \brief Scene annotation records and their output formats
+
+    Annotations are either written as one Pascal VOC XML file per scene, or
+    appended to binary files holding many scenes each, which may later be
+    exported to VOC XML.
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _ANNOTATIONS_HH_
+#define _ANNOTATIONS_HH_
+
+// Gazebo
+#include <gazebo/gazebo_client.hh>
+
+// File streams
+#include <fstream>
+// Smart pointers
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Binary annotation file signature
+#define ANNOTATIONS_MAGIC       "GAPA"
+/// Binary annotation format version
+#define ANNOTATIONS_VERSION     2
+/// Extension of binary annotation files
+#define ANNOTATIONS_EXT         ".gapa"
+/// Number of scenes per binary annotation file
+#define ANNOTATIONS_PER_FILE    10000
+/// Size of binary annotation file write buffer, in bytes
+#define ANNOTATIONS_BUFFER      (1 << 20)
+
+/// \brief Annotation of a single object in a scene
+class ObjectAnnotation
+{
+    /// Object class name
+    public: std::string name;
+    /// Object world pose
+    public: ignition::math::Pose3d pose;
+    /// Image bounding box as x min, y min, x max, y max
+    public: int bounding_box[4];
+    /// Object material name
+    public: std::string material;
+};
+
+/// \brief Annotation of a scene
+class SceneAnnotation
+{
+    /// Scene index, which identifies its image
+    public: unsigned int iteration;
+    /// Camera world pose
+    public: ignition::math::Pose3d camera_pose;
+    /// Image width
+    public: unsigned int width;
+    /// Image height
+    public: unsigned int height;
+    /// Image depth
+    public: unsigned int depth;
+    /// Annotations of objects in scene
+    public: std::vector<ObjectAnnotation> objects;
+};
+
+/// \brief Writes scene annotation in Pascal VOC XML format
+/// \param out          Output stream
+/// \param annotation   Scene annotation
+void writeVOC(std::ostream & out, const SceneAnnotation & annotation);
+
+/// \brief Appends scene annotations to binary files
+///
+/// Each file starts with a signature and version, followed by one record
+/// per scene. Values are stored in host byte order (little-endian on
+/// supported platforms), with the layout
+///
+///   uint32 iteration, double[7] camera pose (x y z qw qx qy qz),
+///   uint32 width, uint32 height, uint32 depth, uint32 object count, and
+///   per object string name, double[7] pose, int32[4] bounding box,
+///   string material
+///
+/// where strings are stored as uint16 length followed by their characters.
+/// A new file, named after the index of its first scene, is started every
+/// ANNOTATIONS_PER_FILE scenes, so several generators with disjoint scene
+/// ranges may share an output directory.
+class BinaryAnnotationWriter
+{
+    /// Output directory
+    private: std::string dir;
+    /// Buffer of current output file, must outlive the stream
+    private: std::unique_ptr<char[]> buffer;
+    /// Current output file
+    private: std::ofstream out;
+    /// Number of scenes written to current file
+    private: unsigned int count {0};
+    /// Serialized record, reused between scenes
+    private: std::string record;
+
+    /// \brief Constructor
+    /// \param _dir Output directory
+    public: BinaryAnnotationWriter(const std::string & _dir);
+
+    /// \brief Appends scene annotation to current file
+    /// \param annotation   Scene annotation
+    /// \return Whether annotation was written
+    public: bool write(const SceneAnnotation & annotation);
+
+    /// \brief Opens a new output file
+    /// \param iteration    Index of the first scene in file
+    /// \return Whether file was opened
+    private: bool open(const unsigned int iteration);
+};
+
+/// \brief Reads scene annotations from a binary file
+class BinaryAnnotationReader
+{
+    /// Input file
+    private: std::ifstream in;
+    /// Whether file signature and version are valid
+    private: bool ok {false};
+
+    /// \brief Constructor
+    /// \param path Binary annotation file path
+    public: BinaryAnnotationReader(const std::string & path);
+
+    /// \brief Checks file signature and version
+    /// \return Whether file is valid
+    public: bool valid() const;
+
+    /// \brief Reads next scene annotation
+    ///
+    /// A truncated record, as left by an interrupted generator, is
+    /// treated as the end of the file
+    /// \param annotation   Output scene annotation
+    /// \return False at the end of the file
+    public: bool read(SceneAnnotation & annotation);
+};
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file examples/scene_example/BoxProjector.cc
+    \brief Analytic 2D bounding boxes of primitive objects implementation
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "BoxProjector.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//////////////////////////////////////////////////
+CameraIntrinsics::CameraIntrinsics(int _width, int _height, double _hfov):
+    width(_width), height(_height),
+    fx(0.5 * _width / tan(0.5 * _hfov)), fy(fx),
+    cx(0.5 * _width), cy(0.5 * _height)
+{
+}
+
+//////////////////////////////////////////////////
+CameraIntrinsics::CameraIntrinsics(const gap::msgs::CameraInfo & _info):
+    width(_info.width()), height(_info.height())
+{
+    if (_info.projection_matrix_size() != 16) {
+        *this = CameraIntrinsics(_info.width(), _info.height(), _info.hfov());
+        return;
+    }
+
+    // Camera::Project maps normalized device coordinates to pixels as
+    // u = (x/w + 1) W / 2 and v = (1 - y/w) H / 2, with OpenGL camera axes
+    // x right, y up and z backward, and w = -z
+    const auto & p = _info.projection_matrix();
+    fx = 0.5 * width * p.Get(0);
+    fy = 0.5 * height * p.Get(5);
+    cx = 0.5 * width * (1.0 - p.Get(2));
+    cy = 0.5 * height * (1.0 + p.Get(6));
+}
+
+//////////////////////////////////////////////////
+BoxProjector::BoxProjector(const CameraIntrinsics & _intrinsics):
+    intrinsics(_intrinsics)
+{
+}
+
+//////////////////////////////////////////////////
+bool BoxProjector::project(const Object & object, std::vector<int> & box) const
+{
+    double bounds[4] = {DBL_MAX, DBL_MAX, -DBL_MAX, -DBL_MAX};
+    const ignition::math::Vector3d & scale = object.scale;
+    bool valid = true;
+
+    if (object.type == SPHERE)
+    {
+        valid = extendRound(toOptical(object.pose.Pos()),
+            ignition::math::Vector3d::Zero, 0.5 * scale.X(), bounds);
+    }
+    else if (object.type == CYLINDER)
+    {
+        // Cylinder is the convex hull of its rims
+        ignition::math::Vector3d axis = object.pose.Rot().RotateVector(
+            ignition::math::Vector3d::UnitZ);
+        ignition::math::Vector3d normal = dirToOptical(axis);
+        for (int side = -1; side < 2; side += 2) {
+            ignition::math::Vector3d rim =
+                object.pose.Pos() + axis * (0.5 * side * scale.Z());
+            valid &= extendRound(toOptical(rim), normal, 0.5 * scale.X(), bounds);
+        }
+    }
+    else if (object.type == BOX)
+    {
+        for (int i = 0; i < 8; i++) {
+            ignition::math::Vector3d vertex(
+                ((i & 4)? 0.5 : -0.5) * scale.X(),
+                ((i & 2)? 0.5 : -0.5) * scale.Y(),
+                ((i & 1)? 0.5 : -0.5) * scale.Z());
+            valid &= extendPoint(toOptical(object.pose.CoordPositionAdd(vertex)),
+                bounds);
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    if (!valid) {
+        return false;
+    }
+
+    // Pixel containing each bound
+    box.clear();
+    for (int i = 0; i < 4; i++) {
+        box.push_back(static_cast<int>(floor(bounds[i])));
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////
+ignition::math::Vector3d BoxProjector::toOptical(
+    const ignition::math::Vector3d & point) const
+{
+    return dirToOptical(point - camera_pose.Pos());
+}
+
+//////////////////////////////////////////////////
+ignition::math::Vector3d BoxProjector::dirToOptical(
+    const ignition::math::Vector3d & dir) const
+{
+    ignition::math::Vector3d local = camera_pose.Rot().RotateVectorReverse(dir);
+    return ignition::math::Vector3d(-local.Y(), -local.Z(), local.X());
+}
+
+//////////////////////////////////////////////////
+bool BoxProjector::extendRound(
+    const ignition::math::Vector3d & centre,
+    const ignition::math::Vector3d & normal,
+    const double radius,
+    double bounds[4]) const
+{
+    // Planes x = t z through the camera centre, tangent to the shape, satisfy
+    // (c_x - t c_z)^2 = r^2 (k_xx - 2 t k_xz + t^2 k_zz), where
+    // K = I for spheres and K = I - n n^T for circles
+    const double r2 = radius * radius;
+    const double n_z = normal.Z();
+    const double k_zz = 1.0 - n_z * n_z;
+    if (centre.Z() <= 0 || centre.Z() * centre.Z() <= r2 * k_zz) {
+        return false;
+    }
+
+    const double focal[2] = {intrinsics.fx, intrinsics.fy};
+    const double principal[2] = {intrinsics.cx, intrinsics.cy};
+    for (int axis = 0; axis < 2; axis++)
+    {
+        const double c_a = (axis == 0)? centre.X() : centre.Y();
+        const double n_a = (axis == 0)? normal.X() : normal.Y();
+
+        const double a = centre.Z() * centre.Z() - r2 * k_zz;
+        const double b = -2.0 * (c_a * centre.Z() + r2 * n_a * n_z);
+        const double c = c_a * c_a - r2 * (1.0 - n_a * n_a);
+        const double root = sqrt(std::max(0.0, b * b - 4.0 * a * c));
+
+        const double lo = principal[axis] + focal[axis] * (-b - root) / (2.0 * a);
+        const double hi = principal[axis] + focal[axis] * (-b + root) / (2.0 * a);
+        bounds[axis] = std::min(bounds[axis], lo);
+        bounds[axis + 2] = std::max(bounds[axis + 2], hi);
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////
+bool BoxProjector::extendPoint(
+    const ignition::math::Vector3d & point,
+    double bounds[4]) const
+{
+    if (point.Z() <= 0) {
+        return false;
+    }
+    double u = intrinsics.cx + intrinsics.fx * point.X() / point.Z();
+    double v = intrinsics.cy + intrinsics.fy * point.Y() / point.Z();
+    bounds[0] = std::min(bounds[0], u);
+    bounds[1] = std::min(bounds[1], v);
+    bounds[2] = std::max(bounds[2], u);
+    bounds[3] = std::max(bounds[3], v);
+    return true;
+}
@@ -0,0 +1,127 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file examples/scene_example/BoxProjector.hh
+    \brief Analytic 2D bounding boxes of primitive objects
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _BOX_PROJECTOR_HH_
+#define _BOX_PROJECTOR_HH_
+
+// Object class
+#include "ObjectGrid.hh"
+// Camera intrinsics message
+#include "camera_info.pb.h"
+
+/// \brief Pinhole camera intrinsic parameters
+class CameraIntrinsics
+{
+    /// Image width in pixels
+    public: int width;
+    /// Image height in pixels
+    public: int height;
+    /// Horizontal focal length in pixels
+    public: double fx;
+    /// Vertical focal length in pixels
+    public: double fy;
+    /// Horizontal principal point coordinate
+    public: double cx;
+    /// Vertical principal point coordinate
+    public: double cy;
+
+    /// \brief Constructor
+    ///
+    /// Pixels are square, as in Gazebo cameras, which derive the vertical
+    /// field of view from the horizontal one and the aspect ratio
+    /// \param _width   Image width in pixels
+    /// \param _height  Image height in pixels
+    /// \param _hfov    Horizontal field of view in radians
+    public: CameraIntrinsics(int _width, int _height, double _hfov);
+
+    /// \brief Constructor
+    ///
+    /// Parameters are derived from the projection matrix reported by the
+    /// CameraUtils plugin, which accounts for any principal point offset
+    /// \param _info   Camera image properties and intrinsics
+    public: CameraIntrinsics(const gap::msgs::CameraInfo & _info);
+};
+
+/// \brief Computes exact image bounding boxes of primitive objects
+///
+/// Boxes are obtained in closed form from object pose and scale, rather
+/// than by projecting points sampled on the object surface.
+/// Box vertices are projected directly, whereas the extents of spheres and
+/// cylinder rims are given by the planes through the camera centre tangent
+/// to them. Pixel coordinates follow Camera::Project.
+class BoxProjector
+{
+    /// Camera intrinsic parameters
+    public: CameraIntrinsics intrinsics;
+    /// Camera world pose, with x axis pointing forward and z axis upward
+    public: ignition::math::Pose3d camera_pose;
+
+    /// \brief Constructor
+    /// \param _intrinsics  Camera intrinsic parameters
+    public: BoxProjector(const CameraIntrinsics & _intrinsics);
+
+    /// \brief Computes image bounding box of an object
+    /// \param object   Sphere, cylinder or box object
+    /// \param box      Output bounding box as x min, y min, x max, y max
+    /// \return False if object is not entirely in front of the camera
+    public: bool project(const Object & object, std::vector<int> & box) const;
+
+    /// \brief Transforms world point to optical frame
+    ///
+    /// Optical frame has x axis pointing right, y down and z forward
+    /// \param point    World point
+    /// \return Point in optical frame
+    private: ignition::math::Vector3d toOptical(
+        const ignition::math::Vector3d & point) const;
+
+    /// \brief Rotates world direction to optical frame
+    /// \param dir      World direction
+    /// \return Direction in optical frame
+    private: ignition::math::Vector3d dirToOptical(
+        const ignition::math::Vector3d & dir) const;
+
+    /// \brief Extends image bounds with a sphere or a circle
+    ///
+    /// Circles are given by their normal, spheres by a null normal
+    /// \param centre   Centre in optical frame
+    /// \param normal   Circle normal in optical frame, or zero
+    /// \param radius   Radius
+    /// \param bounds   Image bounds as u min, v min, u max, v max
+    /// \return False if shape is not entirely in front of the camera
+    private: bool extendRound(
+        const ignition::math::Vector3d & centre,
+        const ignition::math::Vector3d & normal,
+        const double radius,
+        double bounds[4]) const;
+
+    /// \brief Extends image bounds with a point
+    /// \param point    Point in optical frame
+    /// \param bounds   Image bounds as u min, v min, u max, v max
+    /// \return False if point is not in front of the camera
+    private: bool extendPoint(
+        const ignition::math::Vector3d & point,
+        double bounds[4]) const;
+};
+
+#endif
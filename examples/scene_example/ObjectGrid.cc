@@ -37,85 +37,77 @@ Object::Object(
     sampleSurface();
 }
 
+std::vector<SurfacePoints> Object::unit_points =
+    Object::unitSurfaces(STEPS_CYLINDER, STEPS_SPHERE);
+
 //////////////////////////////////////////////////
 void Object::sampleSurface()
 {
-    // Generate surface points from object parameters
-    if (type == CYLINDER) {
-
-        double radius = parameters[0];
-        double length = parameters[1];
-
-        // Generate points on the circular edge of the cylinder
-        for (int i = 0; i < TOTAL_STEPS_C ; i++) {
-
-            float x,y,z;
-            x = cos(ANGLE_STEP_C * i) * radius;
-            y = sin(ANGLE_STEP_C * i) * radius;
-            z = 0.5 * length;
-
-            Eigen::Vector4f point1;
-            point1 << x, y, z, 1.0;
-            points.push_back(point1);
-
-            z = -0.5 * length;
-            Eigen::Vector4f point2;
-            point2 << x, y, z, 1.0;
-            points.push_back(point2);
-        }
-
-    } else if (type == SPHERE) {
-
-        double radius = parameters[0];
-
-        for (int i = 0; i < TOTAL_STEPS_S; i++) {
-            for (int j = 0; j < TOTAL_STEPS_S; j++) {
-
-                float x,y,z;
-                x = radius * sin(ANGLE_STEP_S * i) * cos(ANGLE_STEP_S * j);
-                y = radius * sin(ANGLE_STEP_S * i) * sin(ANGLE_STEP_S * j);
-                z = radius * cos(ANGLE_STEP_S * i);
+    const SurfacePoints & unit = unit_points[type];
 
-                Eigen::Vector4f point;
-                point << x, y, z, 1.0;
-                points.push_back(point);
-            }
-        }
-
-    } else if (type == BOX) {
+    // Object scale matches its size along each axis
+    Eigen::Matrix3f transf =
+        Eigen::Quaternionf(pose.Rot().W(), pose.Rot().X(),
+            pose.Rot().Y(), pose.Rot().Z()).toRotationMatrix() *
+        Eigen::Vector3f(scale.X(), scale.Y(), scale.Z()).asDiagonal();
+    Eigen::Vector3f translation(pose.Pos().X(), pose.Pos().Y(), pose.Pos().Z());
 
-        double size_x = parameters[0];
-        double size_y = parameters[1];
-        double size_z = parameters[2];
+    points.noalias() = transf * unit;
+    points.colwise() += translation;
+}
 
-        float x,y,z;
-        for (int i=-1; i < 2 ; i+= 2){
-            for (int j=-1; j < 2; j+= 2){
-                for (int k=-1; k < 2; k+= 2){
+//////////////////////////////////////////////////
+void Object::setSurfaceResolution(int steps_c, int steps_s)
+{
+    unit_points = unitSurfaces(steps_c, steps_s);
+}
 
-                    x = i * size_x / 2.0;
-                    y = j * size_y / 2.0;
-                    z = k * size_z / 2.0;
-                    Eigen::Vector4f point;
-                    point << x, y, z, 1.0;
-                    points.push_back(point);
-                }
-            }
+//////////////////////////////////////////////////
+std::vector<SurfacePoints> Object::unitSurfaces(int steps_c, int steps_s)
+{
+    std::vector<SurfacePoints> surfaces(3);
+    steps_c = std::max(steps_c, 3);
+    steps_s = std::max(steps_s, 4);
+
+    // Sphere, with rings of points between both poles
+    int rings = steps_s / 2;
+    SurfacePoints & sphere = surfaces[SPHERE];
+    sphere.resize(3, 2 + (rings - 1) * steps_s);
+    sphere.col(0) << 0, 0, 0.5;
+    sphere.col(1) << 0, 0, -0.5;
+    for (int i = 1; i < rings; i++) {
+        float polar = M_PI * i / rings;
+        for (int j = 0; j < steps_s; j++) {
+            float azimuth = 2.0 * M_PI * j / steps_s;
+            sphere.col(2 + (i - 1) * steps_s + j) <<
+                0.5 * sin(polar) * cos(azimuth),
+                0.5 * sin(polar) * sin(azimuth),
+                0.5 * cos(polar);
         }
     }
 
-    // Transform Ignition to Eigen
-    Eigen::Matrix3f rot;
-    rot = Eigen::Quaternionf(
-        pose.Rot().W(),pose.Rot().X(),pose.Rot().Y(),pose.Rot().Z());
-
-    Eigen::Matrix4f transf;
-    transf.block(0,0,3,3) = rot;
-    transf.block(0,3,3,1) = Eigen::Vector3f(pose.Pos().X(),pose.Pos().Y(),pose.Pos().Z());
+    // Cylinder, points on the circular edges
+    SurfacePoints & cylinder = surfaces[CYLINDER];
+    cylinder.resize(3, 2 * steps_c);
+    for (int i = 0; i < steps_c; i++) {
+        float angle = 2.0 * M_PI * i / steps_c;
+        float x = 0.5 * cos(angle);
+        float y = 0.5 * sin(angle);
+        cylinder.col(2 * i) << x, y, 0.5;
+        cylinder.col(2 * i + 1) << x, y, -0.5;
+    }
 
-    for (int i = 0; i < points.size(); i++){
-        points[i] = transf * points[i];
+    // Box, its vertices
+    SurfacePoints & box = surfaces[BOX];
+    box.resize(3, 8);
+    for (int i = 0; i < 8; i++) {
+        box.col(i) <<
+            ((i & 4)? 0.5 : -0.5),
+            ((i & 2)? 0.5 : -0.5),
+            ((i & 1)? 0.5 : -0.5);
     }
+
+    return surfaces;
 }
 
 //////////////////////////////////////////////////
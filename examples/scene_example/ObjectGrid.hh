@@ -22,6 +22,9 @@
     \author Rui Figueiredo : ruipimentelfigueiredo
 */
 
+#ifndef _OBJECT_GRID_HH_
+#define _OBJECT_GRID_HH_
+
 // WorldUtils request
 #include "world_utils_request.pb.h"
 
@@ -40,6 +43,14 @@
 /// Spawn box object
 #define BOX       2
 
+/// Default number of angular steps in cylinder surface sampling
+#define STEPS_CYLINDER  12
+/// Default number of angular steps in sphere surface sampling
+#define STEPS_SPHERE    12
+
+/// 3D points stored as rows of x, y and z coordinates
+typedef Eigen::Matrix<float, 3, Eigen::Dynamic, Eigen::RowMajor> SurfacePoints;
+
 /// \brief Object in 2D grid
 class Object
 {
@@ -55,21 +66,17 @@ class Object
     public: ignition::math::Vector3d scale;
     /// Object parameter values
     public: std::vector<double> parameters;
-    /// Object surface 3D points
-    public: std::vector<Eigen::Vector4f> points;
+    /// Object surface 3D points, in world frame
+    public: SurfacePoints points;
     /// Object 2D bounding box
     public: std::vector<int> bounding_box;
+    /// Object material name, as reported by VisualUtils
+    public: std::string material;
 
     // Private attributes
 
-    /// Sample 3D points on object surface
-    private: const double ANGLE_STEP_C = 30.0;
-    /// Sample 3D points on object surface
-    private: const double TOTAL_STEPS_C = 360.0 / ANGLE_STEP_C;
-    /// Sample 3D points on object surface
-    private: const double ANGLE_STEP_S = 30.0;
-    /// Sample 3D points on object surface
-    private: const double TOTAL_STEPS_S = 360.0 / ANGLE_STEP_S;
+    /// Surface points of each object type with unit scale, indexed by type
+    private: static std::vector<SurfacePoints> unit_points;
 
     /// \brief Constructor
     /// \param _type        Object type
@@ -86,8 +93,28 @@ class Object
     );
 
     /// \brief Sample 3D points on object surface
+    ///
+    /// Unit surface points of the object type are scaled and transformed
+    /// to the object pose at once
     public: void sampleSurface();
 
+    /// \brief Sets surface sampling resolution of every object type
+    ///
+    /// Affects objects created afterwards, should not be called
+    /// concurrently with object creation
+    /// \param steps_c  Number of angular steps for cylinders
+    /// \param steps_s  Number of angular steps for spheres
+    public: static void setSurfaceResolution(int steps_c, int steps_s);
+
+    /// \brief Samples surface of each object type with unit scale
+    ///
+    /// Objects are centred at the origin, with unit size along each axis
+    /// \param steps_c  Number of angular steps for cylinders
+    /// \param steps_s  Number of angular steps for spheres
+    /// \return Surface points, indexed by object type
+    private: static std::vector<SurfacePoints> unitSurfaces(
+        int steps_c, int steps_s);
+
 };
 
 /// \brief Object 2D grid
@@ -142,3 +169,5 @@ class ObjectGrid
     private: void addRandomObject(int x, int y);
 
 };
+
+#endif
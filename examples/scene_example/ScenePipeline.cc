@@ -0,0 +1,71 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file examples/scene_example/ScenePipeline.cc
+    \brief Scene generation pipeline stages implementation
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "ScenePipeline.hh"
+
+#include <algorithm>
+
+//////////////////////////////////////////////////
+SceneQueue::SceneQueue(const std::size_t _capacity):
+    capacity(std::max<std::size_t>(_capacity, 1))
+{
+}
+
+//////////////////////////////////////////////////
+void SceneQueue::push(std::unique_ptr<Scene> scene)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return scenes.size() < capacity; });
+        scenes.push(std::move(scene));
+    }
+    not_empty.notify_one();
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<Scene> SceneQueue::pop()
+{
+    std::unique_ptr<Scene> scene;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return !scenes.empty() || closed; });
+        if (scenes.empty()) {
+            return scene;
+        }
+        scene = std::move(scenes.front());
+        scenes.pop();
+    }
+    not_full.notify_one();
+    return scene;
+}
+
+//////////////////////////////////////////////////
+void SceneQueue::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    not_empty.notify_all();
+}
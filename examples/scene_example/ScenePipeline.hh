@@ -0,0 +1,95 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file examples/scene_example/ScenePipeline.hh
+    \brief Scene generation pipeline stages
+
+    Scenes flow through three stages: preparation, rendering and annotation
+    output, each running in its own thread and linked by bounded queues.
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _SCENE_PIPELINE_HH_
+#define _SCENE_PIPELINE_HH_
+
+// Custom messages
+#include "visual_utils_request.pb.h"
+
+// Object class
+#include "ObjectGrid.hh"
+
+// Threading
+#include <condition_variable>
+#include <mutex>
+// Queue container
+#include <queue>
+// Smart pointers
+#include <memory>
+
+/// \brief Single scene, as it moves through the pipeline
+class Scene
+{
+    /// Scene index, used for output file names
+    public: int iteration;
+    /// Objects in scene, with annotations once rendered
+    public: std::vector<Object> objects;
+    /// Camera pose
+    public: ignition::math::Pose3d camera_pose;
+    /// Light pose
+    public: ignition::math::Pose3d light_pose;
+    /// VisualUtils request that places objects in scene
+    public: gap::msgs::VisualUtilsRequest msg_visual;
+};
+
+/// \brief Bounded queue of scenes between two pipeline stages
+///
+/// Producers block while the queue is full, so the queue capacity sets how
+/// far a stage may run ahead of the next one.
+class SceneQueue
+{
+    /// Scenes awaiting the next stage
+    private: std::queue<std::unique_ptr<Scene>> scenes;
+    /// Maximum number of queued scenes
+    private: const std::size_t capacity;
+    /// Whether producer has finished
+    private: bool closed {false};
+    /// Mutex for exclusive threaded access
+    private: std::mutex mutex;
+    /// Signalled when a scene is added or the queue is closed
+    private: std::condition_variable not_empty;
+    /// Signalled when a scene is removed
+    private: std::condition_variable not_full;
+
+    /// \brief Constructor
+    /// \param _capacity Maximum number of queued scenes, at least one
+    public: SceneQueue(const std::size_t _capacity);
+
+    /// \brief Adds scene to queue, blocking while queue is full
+    /// \param scene Scene to hand over to next stage
+    public: void push(std::unique_ptr<Scene> scene);
+
+    /// \brief Removes scene from queue, blocking while queue is empty
+    /// \return Next scene, or null once queue is closed and drained
+    public: std::unique_ptr<Scene> pop();
+
+    /// \brief Signals that no more scenes will be added
+    public: void close();
+};
+
+#endif
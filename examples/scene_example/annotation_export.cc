@@ -0,0 +1,71 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file examples/scene_example/annotation_export.cc
+    \brief Exports binary scene annotations to Pascal VOC XML
+
+    Writes one XML file per scene in the given binary annotation files,
+    identical to those written directly by scene_example.
+
+    \author João Borrego : jsbruglie
+*/
+
+// Annotation formats
+#include "Annotations.hh"
+
+#include <unistd.h>
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    std::string dataset_dir {"dataset"};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:")) != EOF)
+    {
+        switch (opt)
+        {
+            case 'd':
+                dataset_dir = optarg; break;
+            default:
+                std::cerr << "usage:   " << argv[0]
+                    << " [-d <dataset output directory>] <annotation files>\n";
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    unsigned int scenes {0};
+    SceneAnnotation annotation;
+    for (int i = optind; i < argc; i++)
+    {
+        BinaryAnnotationReader reader(argv[i]);
+        if (!reader.valid()) {
+            std::cerr << "Invalid annotation file " << argv[i] << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        while (reader.read(annotation))
+        {
+            std::ofstream out(dataset_dir + "/" +
+                std::to_string(annotation.iteration) + ".xml");
+            writeVOC(out, annotation);
+            scenes++;
+        }
+    }
+
+    std::cout << "Exported " << scenes << " scenes to " << dataset_dir << std::endl;
+}
@@ -0,0 +1,316 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file examples/scene_example/scene_driver.cc
+    \brief Sharded scene generation driver implementation
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "scene_driver.hh"
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    DriverOptions options;
+    parseDriverArgs(argc, argv, options);
+
+    // Split scene range in contiguous shards
+    std::vector<Shard> shards;
+    unsigned int size = (options.scenes + options.shards - 1) / options.shards;
+    unsigned int end = options.start + options.scenes;
+    for (unsigned int first = options.start; first < end; first += size)
+    {
+        Shard shard;
+        shard.first = first;
+        shard.end = std::min(first + size, end);
+        shard.port = options.port + shards.size();
+        shards.push_back(shard);
+    }
+
+    // Launch every server at once, then their clients
+    for (auto & shard : shards) {
+        launchServer(shard, options);
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(SERVER_STARTUP));
+    for (auto & shard : shards) {
+        launchClient(shard, options);
+    }
+
+    // Supervise shard processes until all have exited, polling while a
+    // restarted shard waits for its server to start
+    int status;
+    pid_t pid;
+    while (true)
+    {
+        bool pending = launchPendingClients(shards, options);
+        pid = waitpid(-1, &status, (pending)? WNOHANG : 0);
+        if (pid < 0) {
+            break;
+        }
+        if (pid == 0) {
+            std::this_thread::sleep_for(
+                std::chrono::milliseconds(SUPERVISION_POLL));
+            continue;
+        }
+        for (auto & shard : shards) {
+            if (shard.server == pid || shard.client == pid) {
+                onExit(shard, pid, status, options);
+                break;
+            }
+        }
+    }
+
+    // Shards share the output directories, as file names are given by global
+    // scene index, so merging amounts to checking for missing scenes
+    unsigned int missing {0};
+    for (auto & shard : shards)
+    {
+        unsigned int next = nextScene(shard, options);
+        if (shard.status != SHARD_DONE) {
+            std::cerr << "Shard [" << shard.first << ", " << shard.end
+                << ") failed at scene " << next << std::endl;
+        }
+        for (unsigned int i = next; i < shard.end; i++) {
+            if (!annotated(i, options)) {
+                missing++;
+            }
+        }
+    }
+    if (missing) {
+        std::cerr << missing << " scenes missing! Exiting..." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    debugPrintTrace("All " << options.scenes << " scenes generated by "
+        << shards.size() << " shards! Exiting...");
+}
+
+//////////////////////////////////////////////////
+const std::string getDriverUsage(const char* argv_0)
+{
+    return \
+        "usage:   " + std::string(argv_0) + " [options]\n" +
+        "options: -s <number of scenes to generate>\n"  +
+        "         -n <index of the first scene>\n" +
+        "         -k <number of parallel gzserver instances>\n" +
+        "         -p <first Gazebo master port>\n" +
+        "         -r <maximum restarts per shard>\n" +
+        "         -g <random seed>\n" +
+        "         -i <image output directory>\n" +
+        "         -d <dataset output directory>\n" +
+        "         -w <world file>\n" +
+        "         -e <scene generation client executable>\n";
+}
+
+//////////////////////////////////////////////////
+void parseDriverArgs(int argc, char** argv, DriverOptions & options)
+{
+    int opt;
+
+    options.seed = std::random_device{}();
+    while ((opt = getopt(argc,argv,"s: n: k: p: r: g: i: d: w: e:")) != EOF)
+    {
+        switch (opt)
+        {
+            case 's':
+                options.scenes = atoi(optarg); break;
+            case 'n':
+                options.start = atoi(optarg); break;
+            case 'k':
+                options.shards = std::max(atoi(optarg), 1); break;
+            case 'p':
+                options.port = atoi(optarg); break;
+            case 'r':
+                options.restarts = atoi(optarg); break;
+            case 'g':
+                options.seed = strtoull(optarg, nullptr, 10); break;
+            case 'i':
+                options.imgs_dir = optarg; break;
+            case 'd':
+                options.dataset_dir = optarg; break;
+            case 'w':
+                options.world = optarg; break;
+            case 'e':
+                options.client = optarg; break;
+            case '?':
+                std::cerr << getDriverUsage(argv[0]);
+            default:
+                std::cout << std::endl;
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    debugPrint("Parameters:\n" <<
+        "   scenes:      '" << options.scenes << "'\n"
+        "   shards:      '" << options.shards << "'\n"
+        "   seed:        '" << options.seed << "'\n"
+        "   images dir:  '" << options.imgs_dir << "'\n"
+        "   dataset dir: '" << options.dataset_dir <<  "'\n");
+}
+
+//////////////////////////////////////////////////
+pid_t launch(
+    const std::vector<std::string> & args,
+    const unsigned int port,
+    const bool quiet)
+{
+    // Avoid duplicating buffered output in child
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Could not fork " << args[0] << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (pid > 0) {
+        return pid;
+    }
+
+    // Child process
+    std::string uri = "http://localhost:" + std::to_string(port);
+    setenv("GAZEBO_MASTER_URI", uri.c_str(), 1);
+    if (quiet && !freopen("/dev/null", "w", stdout)) {
+        _exit(EXIT_FAILURE);
+    }
+
+    std::vector<char *> argv;
+    for (const auto & arg : args) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    execvp(argv[0], argv.data());
+
+    std::cerr << "Could not run " << args[0] << std::endl;
+    _exit(EXIT_FAILURE);
+}
+
+//////////////////////////////////////////////////
+void stop(pid_t & pid, const int sig)
+{
+    if (pid > 0) {
+        kill(pid, sig);
+        waitpid(pid, nullptr, 0);
+        pid = -1;
+    }
+}
+
+//////////////////////////////////////////////////
+bool annotated(const unsigned int scene, const DriverOptions & options)
+{
+    std::string file = options.dataset_dir + "/" + std::to_string(scene) + ".xml";
+    return access(file.c_str(), F_OK) == 0;
+}
+
+//////////////////////////////////////////////////
+unsigned int nextScene(const Shard & shard, const DriverOptions & options)
+{
+    for (unsigned int i = shard.first; i < shard.end; i++)
+    {
+        if (!annotated(i, options)) {
+            return i;
+        }
+    }
+    return shard.end;
+}
+
+//////////////////////////////////////////////////
+void launchServer(Shard & shard, const DriverOptions & options)
+{
+    shard.server = launch({"gzserver", options.world}, shard.port, true);
+}
+
+//////////////////////////////////////////////////
+void launchClient(Shard & shard, const DriverOptions & options)
+{
+    unsigned int next = nextScene(shard, options);
+
+    debugPrintTrace("Shard [" << shard.first << ", " << shard.end
+        << ") on port " << shard.port << ": scenes " << next << " onwards");
+
+    shard.client = launch({options.client,
+        "-s", std::to_string(shard.end - next),
+        "-n", std::to_string(next),
+        "-g", std::to_string(options.seed),
+        "-i", options.imgs_dir,
+        "-d", options.dataset_dir}, shard.port, false);
+}
+
+//////////////////////////////////////////////////
+void onExit(
+    Shard & shard,
+    const pid_t pid,
+    const int status,
+    const DriverOptions & options)
+{
+    bool success = (pid == shard.client &&
+        WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // Stop whichever process of the pair is still running
+    shard.client_pending = false;
+    if (pid == shard.client) {
+        shard.client = -1;
+        stop(shard.server, SIGINT);
+    } else {
+        shard.server = -1;
+        stop(shard.client, SIGKILL);
+    }
+
+    if (success && nextScene(shard, options) == shard.end) {
+        shard.status = SHARD_DONE;
+        debugPrintTrace("Shard [" << shard.first << ", " << shard.end
+            << ") done");
+        return;
+    }
+
+    if (shard.restarts == options.restarts) {
+        shard.status = SHARD_FAILED;
+        return;
+    }
+
+    // Restart only this shard, resuming from its first missing scene
+    shard.restarts++;
+    std::cerr << "Restarting shard [" << shard.first << ", " << shard.end
+        << ") (" << shard.restarts << "/" << options.restarts << ")"
+        << std::endl;
+    launchServer(shard, options);
+    shard.client_pending = true;
+    shard.client_launch = std::chrono::steady_clock::now() +
+        std::chrono::seconds(SERVER_STARTUP);
+}
+
+//////////////////////////////////////////////////
+bool launchPendingClients(
+    std::vector<Shard> & shards,
+    const DriverOptions & options)
+{
+    bool pending = false;
+    auto now = std::chrono::steady_clock::now();
+    for (auto & shard : shards)
+    {
+        if (!shard.client_pending) {
+            continue;
+        }
+        if (now < shard.client_launch) {
+            pending = true;
+            continue;
+        }
+        shard.client_pending = false;
+        launchClient(shard, options);
+    }
+    return pending;
+}
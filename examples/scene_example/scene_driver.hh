@@ -0,0 +1,209 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file examples/scene_example/scene_driver.hh
+    \brief Sharded scene generation driver
+
+    Splits a range of scenes across several headless gzserver instances,
+    each with its own Gazebo master port and scene_example client.
+    Shards that crash are restarted from their first missing scene.
+
+    \author João Borrego : jsbruglie
+*/
+
+// Debug utilities
+#include "debug.hh"
+
+// POSIX processes
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+
+// Min and max
+#include <algorithm>
+// Strings and containers
+#include <string>
+#include <vector>
+// Sleep
+#include <chrono>
+#include <thread>
+// Random seed
+#include <cstdint>
+#include <random>
+
+//////////////////////////////////////////////////
+
+// Macros
+
+/// Default number of parallel shards
+#define ARG_SHARDS_DEFAULT      4
+/// Default first Gazebo master port
+#define ARG_PORT_DEFAULT        11345
+/// Default maximum number of restarts per shard
+#define ARG_RESTARTS_DEFAULT    3
+/// Default world file
+#define ARG_WORLD_DEFAULT       "worlds/spawner.world"
+/// Default scene generation client executable
+#define ARG_CLIENT_DEFAULT      "./build/bin/scene_example"
+
+/// Shard is generating scenes
+#define SHARD_RUNNING   0
+/// Shard generated every scene in its range
+#define SHARD_DONE      1
+/// Shard exceeded maximum number of restarts
+#define SHARD_FAILED    2
+
+/// Time for gzserver to start before launching its client, in seconds
+#define SERVER_STARTUP  2
+/// Interval between checks for exited processes while a restarted shard
+/// waits for its server to start, in milliseconds
+#define SUPERVISION_POLL 100
+
+//////////////////////////////////////////////////
+
+/// \brief Driver settings
+class DriverOptions
+{
+    /// Number of scenes to generate
+    public: unsigned int scenes {10};
+    /// Index of the first scene
+    public: unsigned int start {0};
+    /// Number of parallel shards
+    public: unsigned int shards {ARG_SHARDS_DEFAULT};
+    /// First Gazebo master port, incremented for each shard
+    public: unsigned int port {ARG_PORT_DEFAULT};
+    /// Maximum number of restarts per shard
+    public: unsigned int restarts {ARG_RESTARTS_DEFAULT};
+    /// Image output directory
+    public: std::string imgs_dir {"imgs"};
+    /// Dataset annotations output directory
+    public: std::string dataset_dir {"dataset"};
+    /// Random seed shared by every client, so that each scene only depends
+    /// on its index
+    public: uint64_t seed {0};
+    /// World file loaded by every gzserver
+    public: std::string world {ARG_WORLD_DEFAULT};
+    /// Scene generation client executable
+    public: std::string client {ARG_CLIENT_DEFAULT};
+};
+
+/// \brief Range of scenes generated by a gzserver and client pair
+class Shard
+{
+    /// Index of first scene
+    public: unsigned int first;
+    /// Index past the last scene
+    public: unsigned int end;
+    /// Gazebo master port
+    public: unsigned int port;
+    /// gzserver process id
+    public: pid_t server {-1};
+    /// Client process id
+    public: pid_t client {-1};
+    /// Number of restarts so far
+    public: unsigned int restarts {0};
+    /// Whether client awaits launch, after its server was restarted
+    public: bool client_pending {false};
+    /// Time at which pending client is launched
+    public: std::chrono::steady_clock::time_point client_launch;
+    /// Shard status
+    public: int status {SHARD_RUNNING};
+};
+
+//////////////////////////////////////////////////
+
+/// Function prototypes
+
+/// \brief Returns string with program usage information
+/// \param argv_0 Program name
+/// \return Program usage
+const std::string getDriverUsage(const char* argv_0);
+
+/// \brief Parses command-line arguments
+/// \param argc     Argument count
+/// \param argv     Argument values
+/// \param options  Output driver settings
+void parseDriverArgs(int argc, char** argv, DriverOptions & options);
+
+/// \brief Launches process with given Gazebo master port
+/// \param args     Program and arguments
+/// \param port     Gazebo master port
+/// \param quiet    Whether to discard process output
+/// \return Process id
+pid_t launch(
+    const std::vector<std::string> & args,
+    const unsigned int port,
+    const bool quiet);
+
+/// \brief Stops process and waits for it to exit
+/// \param pid  Process id, set to -1
+/// \param sig  Signal sent to process
+void stop(pid_t & pid, const int sig);
+
+/// \brief Checks whether annotations of a scene exist
+///
+/// Clients rename annotation files into place once fully written, so an
+/// existing file is complete
+/// \param scene    Scene index
+/// \param options  Driver settings
+/// \return True if annotation file exists
+bool annotated(const unsigned int scene, const DriverOptions & options);
+
+/// \brief Finds first scene of a shard without annotations
+///
+/// Annotations are written in order, so scenes before the returned index
+/// need not be generated again
+/// \param shard    Shard
+/// \param options  Driver settings
+/// \return Index of first missing scene, or shard end if none
+unsigned int nextScene(const Shard & shard, const DriverOptions & options);
+
+/// \brief Launches gzserver for shard
+/// \param shard    Shard
+/// \param options  Driver settings
+void launchServer(Shard & shard, const DriverOptions & options);
+
+/// \brief Launches scene generation client for remaining scenes of shard
+/// \param shard    Shard
+/// \param options  Driver settings
+void launchClient(Shard & shard, const DriverOptions & options);
+
+/// \brief Launches pending clients whose servers had time to start
+/// \param shards   Every shard
+/// \param options  Driver settings
+/// \return Whether any client still awaits launch
+bool launchPendingClients(
+    std::vector<Shard> & shards,
+    const DriverOptions & options);
+
+/// \brief Handles the exit of a shard process
+///
+/// Stops the other process of the shard, and either marks the shard as
+/// done or restarts it from its first missing scene. The restarted client
+/// is launched later by launchPendingClients, so that waiting for its server
+/// does not delay supervision of the other shards
+/// \param shard    Shard
+/// \param pid      Id of process that exited
+/// \param status   Exit status, as returned by waitpid
+/// \param options  Driver settings
+void onExit(
+    Shard & shard,
+    const pid_t pid,
+    const int status,
+    const DriverOptions & options);
@@ -43,23 +43,29 @@ const ignition::math::Vector3d g_light_pos {1.5, 1.5, 5.5};
 const ignition::math::Vector3d g_camera_pos {1.5, 1.5, 3.2};
 // Viewpoint variation
 const int g_viewpoint {FIXED_VIEW};
-
-// Variables that lock progress for synchronous scene generation
-bool g_moved {false};
-std::mutex g_moved_mutex;
-bool g_camera_ready {false};
-std::mutex g_camera_ready_mutex;
-bool g_points_ready {false};
-std::mutex g_points_ready_mutex;
-bool g_visuals_ready {false};
-std::mutex g_visuals_ready_mutex;
+// Compute bounding boxes analytically, instead of projecting surface points
+const bool g_analytic_boxes {true};
+// Angular steps in cylinder surface sampling
+const int g_steps_cylinder {STEPS_CYLINDER};
+// Angular steps in sphere surface sampling
+const int g_steps_sphere {STEPS_SPHERE};
+
+// Maximum time to wait for each plugin response, in seconds
+const double g_timeout {10.0};
+// Locks progress for synchronous scene generation
+Synchronizer g_sync;
 // Set of names of existing objects
 std::set<std::string> g_names;
-// Global camera pose
-ignition::math::Pose3d g_camera_pose;
-// Regex objects
-std::regex g_regex_uid(REGEX_XML_UID);
-std::regex g_regex_model(REGEX_XML_MODEL);
+// Scene currently being rendered
+Scene *g_scene {nullptr};
+// Guards current scene and set of names, shared with response callbacks
+std::mutex g_scene_mutex;
+// Camera image properties and intrinsics, obtained once from CameraUtils
+gap::msgs::CameraInfo g_camera_info;
+// Material catalog size of each visual, obtained once from VisualUtils
+std::map<std::string, unsigned int> g_catalogs;
+// Guards material catalog sizes, shared with response callbacks
+std::mutex g_catalogs_mutex;
 
 //////////////////////////////////////////////////
 int main(int argc, char **argv)
@@ -67,18 +73,25 @@ int main(int argc, char **argv)
     // Command-line arguments
     unsigned int scenes {0};
     unsigned int start {0};
+    unsigned int depth {0};
+    bool binary {false};
+    uint64_t seed {0};
     std::string imgs_dir;
     std::string dataset_dir;
 
     bool success {false};
 
     // Parse command-line arguments
-    parseArgs(argc, argv, scenes, start, imgs_dir, dataset_dir);
+    parseArgs(argc, argv, scenes, start, depth, binary, seed,
+        imgs_dir, dataset_dir);
+    // Set resolution of object surface points, projected for bounding boxes
+    Object::setSurfaceResolution(g_steps_cylinder, g_steps_sphere);
     // Create output directories
     success = createDirectory(dataset_dir);
     success &= createDirectory(imgs_dir);
-    for (int i = start; i < scenes + start; i+= 100) {
-        std::string imgs_subdir(imgs_dir + std::to_string(i / 100) + "00/");
+    // One subdirectory per hundred scenes, range may start mid-hundred
+    for (int i = start / 100; scenes && i <= (scenes + start - 1) / 100; i++) {
+        std::string imgs_subdir(imgs_dir + std::to_string(i) + "00/");
         success &= createDirectory(imgs_subdir);
     }
     if (!success) {
@@ -129,9 +142,28 @@ int main(int argc, char **argv)
     setPhysics(pub_world, false);
     debugPrintTrace("Disable physics engine");
 
+    // Remove objects left by previous clients, so server can be reused.
+    // In pool mode, as in spawner.world, models are parked instead, and the
+    // spawn below reuses them rather than inserting new ones
+    gap::msgs::WorldUtilsRequest msg_reset;
+    unsigned int reset_id = g_sync.nextId();
+    msg_reset.set_type(RESET);
+    msg_reset.set_id(reset_id);
+    pub_world->Publish(msg_reset);
+    waitFor(SYNC_RESET, reset_id, "world reset");
+    debugPrintTrace("World reset");
+
+    // Register templates of dynamic objects, only sent once
+    gap::msgs::WorldUtilsRequest msg_register;
+    msg_register.set_type(REGISTER);
+    addTemplates(msg_register);
+    pub_world->Publish(msg_register);
+
     // Spawn required objects
     gap::msgs::WorldUtilsRequest msg_spawn;
+    unsigned int spawn_id = g_sync.nextId();
     msg_spawn.set_type(SPAWN);
+    msg_spawn.set_id(spawn_id);
     addModelFromFile(msg_spawn, "models/custom_sun.sdf");
     addModelFromFile(msg_spawn, "models/custom_ground.sdf");
     addModelFromFile(msg_spawn, "models/custom_camera.sdf");
@@ -147,84 +179,98 @@ int main(int argc, char **argv)
     msg_options.set_extension(".png");
     pub_camera->Publish(msg_options);
 
+    // Obtain camera intrinsics once, for local projection and annotations
+    gap::msgs::CameraUtilsRequest msg_info;
+    msg_info.set_type(INFO_REQUEST);
+    pub_camera->Publish(msg_info);
+    waitFor(SYNC_INFO, Synchronizer::ANY, "camera info");
+    debugPrintTrace("Camera " << g_camera_info.width() << "x"
+        << g_camera_info.height());
+
     // Wait for a subscriber to connect to this publisher
     pub_visual->WaitForConnection();
-    std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+    // Wait for every object to be spawned
+    waitFor(SYNC_SPAWN, spawn_id, "spawn");
     debugPrintTrace("Done waiting for spawn");
 
-    // Light poses
-    ignition::math::Pose3d light_pose;
+    // Materials are picked in the client, so that scenes are reproducible
+    requestCatalogs(pub_visual);
+    debugPrintTrace("Material catalogs received");
 
-    // Main loop
-    for (int iteration = start; iteration < scenes + start; iteration++) {
+    // Id of latest light move request
+    unsigned int light_id {Synchronizer::ANY};
 
-        // Populate grid with random objects
-        int num_objects = (getRandomInt(g_obj_min, g_obj_max));
-        g_grid.populate(num_objects);
-        // Create a set with the names of created objects
-        createNameSet();
+    // Scenes are prepared and their annotations written in separate threads,
+    // overlapping with rendering, which is bound by plugin round-trips
+    SceneQueue prepared(depth);
+    SceneQueue rendered(depth);
+    std::thread preparer(prepareScenes, std::ref(prepared),
+        std::cref(g_camera_info), start, scenes, seed);
+    std::thread writer(writeScenes, std::ref(rendered), dataset_dir, binary);
 
-        debugPrintTrace("Scene (" << iteration << "/"
-            << scenes + start - 1 << "): " << num_objects << " objects");
-
-        // Create message with desired 3D points to project in camera plane
-        gap::msgs::CameraUtilsRequest msg_points;
-        msg_points.set_type(PROJECTION_REQUEST);
-        addProjections(msg_points);
+    // Main loop
+    while (std::unique_ptr<Scene> scene = prepared.pop())
+    {
+        {
+            std::lock_guard<std::mutex> lock(g_scene_mutex);
+            // Expose scene to response callbacks
+            g_scene = scene.get();
+            // Create a set with the names of created objects
+            createNameSet(*scene);
+        }
 
-        // Calculate new camera and light poses
-        g_camera_pose = getRandomCameraPose();
+        debugPrintTrace("Scene (" << scene->iteration << "/"
+            << scenes + start - 1 << "): "
+            << scene->objects.size() << " objects");
 
         // Request move light
         if (g_move_light)
         {
-            light_pose = getRandomLightPose();
             gap::msgs::WorldUtilsRequest msg_move;
+            light_id = g_sync.nextId();
             msg_move.set_type(WORLD_MOVE);
-            addMoveObject(msg_move, "custom_sun", true, light_pose);
+            msg_move.set_id(light_id);
+            addMoveObject(msg_move, "custom_sun", true, scene->light_pose);
             pub_world->Publish(msg_move);
         }
 
         // Update scene
-        gap::msgs::VisualUtilsRequest msg_visual;
-        msg_visual.set_type(UPDATE);
-        updateObjects(msg_visual);
-        pub_visual->Publish(msg_visual);
+        pub_visual->Publish(scene->msg_visual);
 
-        moveCamera(pub_camera);
+        moveCamera(pub_camera, scene->camera_pose);
         // Wait for camera to move to new position
-        while (waitForMove()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
+        waitFor(SYNC_CAMERA, Synchronizer::ANY, "camera move");
         debugPrintTrace("Camera moved");
 
         // Wait for visuals to update
-        while (waitForVisuals()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
+        waitFor(SYNC_VISUALS, Synchronizer::ANY, "visual update");
         debugPrintTrace("Visuals moved");
 
-        // Capture the scene and save it to a file
-        captureScene(pub_camera, iteration);
-        while (waitForCamera()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // Wait for light to move, so that capture has updated lighting
+        if (g_move_light)
+        {
+            waitFor(SYNC_LIGHT, light_id, "light move");
+            debugPrintTrace("Light moved");
         }
-        debugPrintTrace("Scene captured");
 
-        // Request point projection
-        pub_camera->Publish(msg_points);
+        captureScene(pub_camera, scene->iteration);
+        waitFor(SYNC_CAPTURE, Synchronizer::ANY, "capture");
+        debugPrintTrace("Scene captured");
 
-        // Wait for projections
-        while (waitForProjections()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // Hand scene over for annotation output, once late responses can
+        // no longer reach it
+        {
+            std::lock_guard<std::mutex> lock(g_scene_mutex);
+            g_scene = nullptr;
         }
-
-        debugPrintTrace("Projections received");
-
-        // Save annotations to file
-        storeAnnotations(dataset_dir, iteration);
+        rendered.push(std::move(scene));
     }
 
+    // Wait for remaining annotations to be saved
+    rendered.close();
+    preparer.join();
+    writer.join();
+
     // Force save camera raw data buffer
 
     // Clean up
@@ -253,6 +299,27 @@ void addModelFromFile(
     object->set_sdf(model_sdf);
 }
 
+//////////////////////////////////////////////////
+void addTemplates(gap::msgs::WorldUtilsRequest & msg)
+{
+    const std::vector<std::string> types = {"sphere", "cylinder","box"};
+
+    for (int i = 0; i < types.size(); i++)
+    {
+        // Read file to SDF string
+        std::string file_name = "models/custom_" + types[i] + ".sdf";
+        std::ifstream infile {file_name};
+        std::string sdf {
+            std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>()
+        };
+
+        // Add template to request message
+        gap::msgs::Object *object = msg.add_object();
+        object->set_template_id(types[i]);
+        object->set_sdf(sdf);
+    }
+}
+
 //////////////////////////////////////////////////
 void addDynamicModels(gap::msgs::WorldUtilsRequest & msg)
 {
@@ -262,34 +329,92 @@ void addDynamicModels(gap::msgs::WorldUtilsRequest & msg)
     {
         for (int j = 1; j <= g_obj_max; j++)
         {
-            // Read file to SDF string
-            std::string file_name = "models/custom_" + types[i] + ".sdf";
-            std::ifstream infile {file_name};
-            std::string sdf {
-                std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>()
-            };
-
+            // Model name, also replaces <uid> (VisualPlugin parameter)
             std::string name = types[i] + "_" + std::to_string(j);
-            // Replace content inside <uid> tags in model SDF (VisualPlugin parameter)
-            std::string uid = "<uid>" + name + "</uid>";
-            sdf = std::regex_replace(sdf, g_regex_uid, uid);
-
-            // Replace model name inside <model name=""> tag
-            std::string model = "<model name=\"" + name + "\">";
-            sdf = std::regex_replace(sdf, g_regex_model, model);
 
             // Add object to request message
             gap::msgs::Object *object = msg.add_object();
             object->set_model_type(CUSTOM);
-            object->set_sdf(sdf);
+            object->set_template_id(types[i]);
+            object->set_name(name);
+        }
+    }
+}
+
+//////////////////////////////////////////////////
+void prepareScenes(
+    SceneQueue & queue,
+    const gap::msgs::CameraInfo & info,
+    const unsigned int start,
+    const unsigned int scenes,
+    const uint64_t seed)
+{
+    BoxProjector projector((CameraIntrinsics(info)));
+    CameraProjector camera(info);
+
+    for (unsigned int iteration = start; iteration < scenes + start; iteration++)
+    {
+        std::unique_ptr<Scene> scene(new Scene);
+        scene->iteration = iteration;
+        // Scene only depends on seed and its index, even across shards
+        seedRandom(seed, iteration);
+
+        // Populate grid with random objects
+        int num_objects = (getRandomInt(g_obj_min, g_obj_max));
+        g_grid.populate(num_objects);
+        scene->objects = g_grid.objects;
+
+        // Calculate new camera and light poses
+        scene->camera_pose = getRandomCameraPose();
+        if (g_move_light) {
+            scene->light_pose = getRandomLightPose();
         }
+
+        // Create scene update message
+        scene->msg_visual.set_type(UPDATE);
+        updateObjects(scene->msg_visual, *scene);
+        // Obtain bounding boxes from object and camera poses, if possible,
+        // otherwise from the projection of object surface points
+        projector.camera_pose = scene->camera_pose;
+        camera.setPose(scene->camera_pose);
+        for (auto & object : scene->objects) {
+            if (!g_analytic_boxes || !projector.project(object, object.bounding_box)) {
+                projectSurface(camera, object);
+            }
+        }
+
+        queue.push(std::move(scene));
     }
+    queue.close();
 }
 
 //////////////////////////////////////////////////
-void updateObjects(gap::msgs::VisualUtilsRequest & msg)
+void writeScenes(
+    SceneQueue & queue,
+    const std::string & path,
+    const bool binary)
 {
-    int total = g_grid.objects.size();
+    std::unique_ptr<BinaryAnnotationWriter> writer;
+    if (binary) {
+        writer.reset(new BinaryAnnotationWriter(path));
+    }
+
+    while (std::unique_ptr<Scene> scene = queue.pop())
+    {
+        SceneAnnotation annotation = annotate(*scene);
+        bool stored = (writer)?
+            writer->write(annotation) : storeAnnotations(path, annotation);
+        if (!stored) {
+            std::cerr << "Error writing annotations! Exiting..." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+//////////////////////////////////////////////////
+void updateObjects(gap::msgs::VisualUtilsRequest & msg, const Scene & scene)
+{
+    int total = scene.objects.size();
 
     // Object parameters
     std::string name;
@@ -297,9 +422,9 @@ void updateObjects(gap::msgs::VisualUtilsRequest & msg)
     ignition::math::Vector3d scale;
 
     for  (int i = 0; i < total; i++) {
-        name = g_grid.objects.at(i).name;
-        pose = g_grid.objects.at(i).pose;
-        scale = g_grid.objects.at(i).scale;
+        name = scene.objects.at(i).name;
+        pose = scene.objects.at(i).pose;
+        scale = scene.objects.at(i).scale;
 
         gazebo::msgs::Pose *msg_pose = msg.add_poses();
         gazebo::msgs::Vector3d *msg_scale = msg.add_scale();
@@ -307,8 +432,61 @@ void updateObjects(gap::msgs::VisualUtilsRequest & msg)
         msg.add_targets(name);
         gazebo::msgs::Set(msg_pose, pose);
         gazebo::msgs::Set(msg_scale, scale);
+        msg.add_material_ids(getRandomMaterialId(name));
     }
     msg.add_targets("ground");
+    msg.add_material_ids(getRandomMaterialId("ground"));
+}
+
+//////////////////////////////////////////////////
+int getRandomMaterialId(const std::string & name)
+{
+    // Late replies to repeated catalog requests may still arrive
+    std::lock_guard<std::mutex> lock(g_catalogs_mutex);
+    auto it = g_catalogs.find(name);
+    if (it == g_catalogs.end() || it->second == 0) {
+        return -1;
+    }
+    return getRandomInt(0, it->second - 1);
+}
+
+//////////////////////////////////////////////////
+void requestCatalogs(gazebo::transport::PublisherPtr pub)
+{
+    std::vector<std::string> names {"ground"};
+    const std::vector<std::string> types = {"sphere", "cylinder","box"};
+    for (const auto & type : types) {
+        for (int j = 1; j <= g_obj_max; j++) {
+            names.push_back(type + "_" + std::to_string(j));
+        }
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() +
+        std::chrono::duration<double>(g_timeout);
+    while (true)
+    {
+        gap::msgs::VisualUtilsRequest msg;
+        msg.set_type(CATALOG_REQUEST);
+        {
+            std::lock_guard<std::mutex> lock(g_catalogs_mutex);
+            for (const auto & name : names) {
+                if (!g_catalogs.count(name)) {
+                    msg.add_targets(name);
+                }
+            }
+        }
+        if (msg.targets_size() == 0) {
+            return;
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            std::cerr << "Timed out waiting for material catalogs! Exiting..."
+                << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        g_sync.clear(SYNC_CATALOG);
+        pub->Publish(msg);
+        g_sync.wait(SYNC_CATALOG, Synchronizer::ANY, CATALOG_RETRY);
+    }
 }
 
 //////////////////////////////////////////////////
@@ -387,12 +565,12 @@ ignition::math::Pose3d getRandomLightPose()
 }
 
 //////////////////////////////////////////////////
-void createNameSet()
+void createNameSet(const Scene & scene)
 {
-    int num_obj = g_grid.objects.size();
+    int num_obj = scene.objects.size();
     for (int i = 0; i < num_obj; i++)
     {
-        std::string name(g_grid.objects.at(i).name);
+        std::string name(scene.objects.at(i).name);
         g_names.emplace(name);
     }
 
@@ -404,33 +582,31 @@ void createNameSet()
 }
 
 //////////////////////////////////////////////////
-void addProjections(gap::msgs::CameraUtilsRequest & msg)
+void projectSurface(const CameraProjector & camera, Object & object)
 {
-    int num_obj = g_grid.objects.size();
-    for (int i = 0; i < num_obj; i++)
-    {
-        gap::msgs::PointProjection *proj = msg.add_projections();
+    const int num_points = object.points.cols();
+    std::vector<int> u(num_points), v(num_points);
 
-        int num_points = g_grid.objects[i].points.size();
-        for (int j = 0; j < num_points; j++)
-        {
-            gazebo::msgs::Vector3d *points_msg = proj->add_point3();
-            points_msg->set_x(g_grid.objects[i].points[j](0));
-            points_msg->set_y(g_grid.objects[i].points[j](1));
-            points_msg->set_z(g_grid.objects[i].points[j](2));
-        }
-        proj->set_name(g_grid.objects[i].name);
-    }
+    // Rows of surface points hold contiguous x, y and z coordinates
+    camera.project(object.points.row(0).data(), object.points.row(1).data(),
+        object.points.row(2).data(), num_points, u.data(), v.data());
+
+    auto u_bounds = std::minmax_element(u.begin(), u.end());
+    auto v_bounds = std::minmax_element(v.begin(), v.end());
+    object.bounding_box = {
+        *u_bounds.first, *v_bounds.first, *u_bounds.second, *v_bounds.second};
 }
 
 //////////////////////////////////////////////////
-void moveCamera(gazebo::transport::PublisherPtr pub)
+void moveCamera(
+    gazebo::transport::PublisherPtr pub,
+    const ignition::math::Pose3d & pose)
 {
     gap::msgs::CameraUtilsRequest msg;
     msg.set_type(MOVE_REQUEST);
 
     gazebo::msgs::Pose *pose_msg = new gazebo::msgs::Pose();
-    gazebo::msgs::Set(pose_msg, g_camera_pose);
+    gazebo::msgs::Set(pose_msg, pose);
     msg.set_allocated_pose(pose_msg);
 
     pub->Publish(msg, false);
@@ -446,58 +622,49 @@ void captureScene(gazebo::transport::PublisherPtr pub, int iteration)
 }
 
 //////////////////////////////////////////////////
-bool waitForMove()
+void waitFor(const int event, const unsigned int id, const std::string & what)
 {
-    std::lock_guard<std::mutex> lock(g_moved_mutex);
-    if (g_moved) {
-        g_moved = false;
-        return false;
+    if (!g_sync.wait(event, id, g_timeout)) {
+        std::cerr << "Timed out waiting for " << what << "! Exiting..."
+            << std::endl;
+        exit(EXIT_FAILURE);
     }
-    return true;
-}
-
-//////////////////////////////////////////////////
-bool waitForVisuals()
-{
-    std::lock_guard<std::mutex> lock(g_visuals_ready_mutex);
-    if (g_visuals_ready) {
-        g_visuals_ready = false;
-        return false;
-    }
-    return true;
-}
-
-//////////////////////////////////////////////////
-bool waitForCamera()
-{
-    std::lock_guard<std::mutex> lock(g_camera_ready_mutex);
-    if (g_camera_ready) {
-        g_camera_ready = false;
-        return false;
-    }
-    return true;
-}
-
-//////////////////////////////////////////////////
-bool waitForProjections()
-{
-    std::lock_guard<std::mutex> lock(g_points_ready_mutex);
-    if (g_points_ready) {
-        g_points_ready = false;
-        return false;
-    }
-    return true;
 }
 
 //////////////////////////////////////////////////
 void onVisualUtilsResponse(VisualUtilsResponsePtr &_msg)
 {
-    if (_msg->type() == UPDATED)
+    if (_msg->type() == CATALOG_RESPONSE)
     {
-        g_names.erase(_msg->origin());
+        std::lock_guard<std::mutex> lock(g_catalogs_mutex);
+        for (int i = 0; i < _msg->origin_size() &&
+            i < _msg->catalog_size_size(); i++)
+        {
+            g_catalogs[_msg->origin(i)] = _msg->catalog_size(i);
+        }
+        g_sync.notify(SYNC_CATALOG);
+    }
+    else if (_msg->type() == UPDATED)
+    {
+        std::lock_guard<std::mutex> lock(g_scene_mutex);
+        // Every visual updated by a request is reported at once
+        for (int i = 0; i < _msg->origin_size(); i++)
+        {
+            // Record applied material for scene annotations
+            if (g_scene && i < _msg->material_size() &&
+                !_msg->material(i).empty())
+            {
+                for (auto & object : g_scene->objects) {
+                    if (object.name == _msg->origin(i)) {
+                        object.material = _msg->material(i);
+                        break;
+                    }
+                }
+            }
+            g_names.erase(_msg->origin(i));
+        }
         if (g_names.empty()) {
-            std::lock_guard<std::mutex> lock(g_visuals_ready_mutex);
-            g_visuals_ready = true;
+            g_sync.notify(SYNC_VISUALS);
         }
     }
 }
@@ -505,7 +672,23 @@ void onVisualUtilsResponse(VisualUtilsResponsePtr &_msg)
 //////////////////////////////////////////////////
 void onWorldUtilsResponse(WorldUtilsResponsePtr &_msg)
 {
-    // Unused
+    if (_msg->type() == SPAWNED)
+    {
+        for (int i = 0; i < _msg->name_size(); i++) {
+            if (!_msg->success(i)) {
+                std::cerr << "Failed to spawn " << _msg->name(i) << std::endl;
+            }
+        }
+        g_sync.notify(SYNC_SPAWN, _msg->id());
+    }
+    else if (_msg->type() == REMOVED)
+    {
+        g_sync.notify(SYNC_RESET, _msg->id());
+    }
+    else if (_msg->type() == WORLD_MOVED)
+    {
+        g_sync.notify(SYNC_LIGHT, _msg->id());
+    }
 }
 
 //////////////////////////////////////////////////
@@ -513,52 +696,21 @@ void onCameraUtilsResponse(CameraUtilsResponsePtr &_msg)
 {
     if (_msg->type() == MOVE_RESPONSE)
     {
-        std::lock_guard<std::mutex> lock(g_moved_mutex);
-        g_moved = true;
+        g_sync.notify(SYNC_CAMERA);
     }
     else if (_msg->type() == CAPTURE_RESPONSE)
     {
         if (_msg->success()) {
-            std::lock_guard<std::mutex> lock(g_camera_ready_mutex);
-            g_camera_ready = true;
+            g_sync.notify(SYNC_CAPTURE);
         }
     }
-    else if (_msg->type() == PROJECTION_RESPONSE)
+    else if (_msg->type() == INFO_RESPONSE)
     {
-        int objects = _msg->projections_size();
-        int x_min, x_max, y_min, y_max;
-        int x_tmp, y_tmp;
-
-        // Ensure projections correspond to desired camera pose
-        ignition::math::Pose3d camera_pose(gazebo::msgs::ConvertIgn(_msg->pose()));
-        if (camera_pose != g_camera_pose) return;
-
-        for (int i = 0; i < objects; i++)
-        {
-            int points = _msg->projections(i).point2_size();
-            x_min = y_min = INT_MAX;
-            x_max = y_max = INT_MIN;
-            for (int j = 0; j < points; j++)
-            {
-                // Obtain 2D bounding box
-                x_tmp = _msg->projections(i).point2(j).x();
-                y_tmp = _msg->projections(i).point2(j).y();
-                if (x_min > x_tmp) x_min = x_tmp;
-                if (x_max < x_tmp) x_max = x_tmp;
-                if (y_min > y_tmp) y_min = y_tmp;
-                if (y_max < y_tmp) y_max = y_tmp;
-            }
-            // Store bounding box
-            g_grid.objects[i].bounding_box.push_back(x_min);
-            g_grid.objects[i].bounding_box.push_back(y_min);
-            g_grid.objects[i].bounding_box.push_back(x_max);
-            g_grid.objects[i].bounding_box.push_back(y_max);
+        // Only written before pipeline threads start
+        if (_msg->has_info() && !g_camera_info.has_width()) {
+            g_camera_info = _msg->info();
+            g_sync.notify(SYNC_INFO);
         }
-
-        debugPrintTrace("DONE");
-
-        std::lock_guard<std::mutex> lock(g_points_ready_mutex);
-        g_points_ready = true;
     }
 }
 
@@ -572,57 +724,45 @@ void setPhysics(gazebo::transport::PublisherPtr pub, bool enable)
 }
 
 //////////////////////////////////////////////////
-void storeAnnotations(
-    const std::string & path,
-    const int iteration)
+SceneAnnotation annotate(const Scene & scene)
 {
-    std::string ext_img = ".png";
-    std::string ext_data = ".xml";
-    std::string image_name = std::to_string(iteration / 100) + "00/" +
-        std::to_string(iteration) + ext_img;
-    std::string data_name = std::to_string(iteration) + ext_data;
-
-    std::ofstream out(path+"/"+data_name);
-
-    // TODO - Obtain directly from camera instead
-    // These values are set in loaded SDF model - models/custom_camera.sdf
-    int camera_width = 1920;
-    int camera_height = 1080;
-    int camera_depth = 3;
-
-    out << "<annotation>\n"
-        << "  <folder>images</folder>\n"
-        << "  <filename>" + image_name + "</filename>\n"
-        << "  <source>\n"
-        << "    <database>The SHAPE2018 Database</database>\n"
-        << "    <annotation>SHAPE SHAPE2018</annotation>\n"
-        << "    <image>" << image_name <<"</image>\n"
-        << "    <pose>" << g_camera_pose <<"</pose>\n"
-        << "  </source>\n"
-        << "  <size>\n"
-        << "    <width>"  << camera_width  << "</width>\n"
-        << "    <height>" << camera_height << "</height>\n"
-        << "    <depth>"  << camera_depth  << "</depth>\n"
-        << "  </size>\n"
-        << "  <segmented>1</segmented>\n";
-
-    for (int i = 0; i < g_grid.objects.size(); i++)
+    SceneAnnotation annotation;
+    annotation.iteration = scene.iteration;
+    annotation.camera_pose = scene.camera_pose;
+    annotation.width = g_camera_info.width();
+    annotation.height = g_camera_info.height();
+    annotation.depth = g_camera_info.depth();
+
+    annotation.objects.resize(scene.objects.size());
+    for (int i = 0; i < scene.objects.size(); i++)
     {
-        Object object = g_grid.objects[i];
-        out << "  <object>\n"
-            << "    <name>" << g_grid.TYPES[object.type] << "</name>\n"
-            << "    <pose>" << object.pose << "</pose>\n"
-            << "    <truncated>0</truncated>\n"
-            << "    <difficult>1</difficult>\n"
-            << "    <bndbox>\n"
-            << "      <xmin>"<< object.bounding_box[0] <<"</xmin>\n"
-            << "      <ymin>"<< object.bounding_box[1] <<"</ymin>\n"
-            << "      <xmax>"<< object.bounding_box[2] <<"</xmax>\n"
-            << "      <ymax>"<< object.bounding_box[3] <<"</ymax>\n"
-            << "    </bndbox>\n"
-            << "  </object>\n";
+        const Object & object = scene.objects[i];
+        ObjectAnnotation & object_annotation = annotation.objects[i];
+        object_annotation.name = g_grid.TYPES[object.type];
+        object_annotation.pose = object.pose;
+        object_annotation.material = object.material;
+        for (int j = 0; j < 4; j++) {
+            object_annotation.bounding_box[j] =
+                (j < object.bounding_box.size())? object.bounding_box[j] : 0;
+        }
     }
+    return annotation;
+}
 
-    out << "</annotation>";
+//////////////////////////////////////////////////
+bool storeAnnotations(
+    const std::string & path,
+    const SceneAnnotation & annotation)
+{
+    std::string data_name = std::to_string(annotation.iteration) + ".xml";
+    std::string file = path + "/" + data_name;
+    std::string tmp = file + ".tmp";
+    std::ofstream out(tmp);
+    writeVOC(out, annotation);
     out.close();
+    if (!out) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return (std::rename(tmp.c_str(), file.c_str()) == 0);
 }
@@ -42,28 +42,41 @@
 
 // Utilities
 #include "utils.hh"
+// Synchronization with plugin responses
+#include "Synchronizer.hh"
 // Object class
 #include "ObjectGrid.hh"
+// Pipeline stages
+#include "ScenePipeline.hh"
+// Analytic bounding boxes
+#include "BoxProjector.hh"
+// Projection of object surface points
+#include "CameraProjector.hh"
+// Annotation output
+#include "Annotations.hh"
 
 // I/O streams
 #include <iostream>
 // File streams
 #include <fstream>
+// Rename files
+#include <cstdio>
 // Iterating over the contents of a dir
 #include <boost/filesystem.hpp>
-// Protecting variables
-#include <mutex>
 // Set container
 #include <set>
-// Sleep
+// Map container
+#include <map>
+// Catalog request deadline
 #include <chrono>
+// Pipeline stage threads
 #include <thread>
-// Regular expressions
-#include <regex>
+// Scene shared with response callbacks
+#include <mutex>
 // Linear algebra
 #include <Eigen/Dense>
-// INT MAX
-#include <climits>
+// Bounds of projected points
+#include <algorithm>
 
 //////////////////////////////////////////////////
 
@@ -76,15 +89,29 @@
 // Moving viewpoint, change in position and rotation
 #define MOVING_VIEW_POS_ROT 2
 
-// Do not raise documentation error 
-//! @cond DoNotRaiseWarning
-
-/// Matches name field in <model name=""> XML tag
-#define REGEX_XML_MODEL "<model name=(\"([^\"]|\"\")*\")>"
-/// Matches string enclosed in <uid> XML tags
-#define REGEX_XML_UID   "<uid>[\\s\\S]*?<\\/uid>"
+//////////////////////////////////////////////////
 
-//! @endcond
+// Synchronization events
+
+/// Spawn request completed
+#define SYNC_SPAWN          0
+/// Light moved
+#define SYNC_LIGHT          1
+/// Camera moved
+#define SYNC_CAMERA         2
+/// Visuals updated
+#define SYNC_VISUALS        3
+/// Frame saved to disk
+#define SYNC_CAPTURE        4
+/// Reset request completed
+#define SYNC_RESET          5
+/// Camera intrinsics received
+#define SYNC_INFO           6
+/// Material catalog sizes received
+#define SYNC_CATALOG        7
+
+/// Interval between material catalog requests, in seconds
+#define CATALOG_RETRY       0.5
 
 //////////////////////////////////////////////////
 
@@ -100,12 +127,12 @@
 #define CAPTURE_REQUEST         gap::msgs::CameraUtilsRequest::CAPTURE
 /// Response acknowledging captured frame
 #define CAPTURE_RESPONSE        gap::msgs::CameraUtilsResponse::CAPTURE
-/// Request 3D to 2D point projection
-#define PROJECTION_REQUEST      gap::msgs::CameraUtilsRequest::PROJECTION
-/// Response 3D to 2D point projection
-#define PROJECTION_RESPONSE     gap::msgs::CameraUtilsResponse::PROJECTION
 /// Request to change camera plugin settings
 #define OPTIONS                 gap::msgs::CameraUtilsRequest::OPTIONS
+/// Request camera image properties and intrinsics
+#define INFO_REQUEST            gap::msgs::CameraUtilsRequest::INFO
+/// Response with camera image properties and intrinsics
+#define INFO_RESPONSE           gap::msgs::CameraUtilsResponse::INFO
 
 // Visual utils
 
@@ -113,6 +140,10 @@
 #define UPDATE      gap::msgs::VisualUtilsRequest::UPDATE
 /// Visual updated response
 #define UPDATED     gap::msgs::VisualUtilsResponse::UPDATED
+/// Request material catalog sizes
+#define CATALOG_REQUEST     gap::msgs::VisualUtilsRequest::CATALOG
+/// Response with material catalog sizes
+#define CATALOG_RESPONSE    gap::msgs::VisualUtilsResponse::CATALOG
 
 // World utils
 
@@ -122,6 +153,16 @@
 #define WORLD_MOVE      gap::msgs::WorldUtilsRequest::MOVE
 /// Start or stop physcis simulation
 #define PHYSICS         gap::msgs::WorldUtilsRequest::PHYSICS
+/// Register custom SDF template
+#define REGISTER        gap::msgs::WorldUtilsRequest::REGISTER
+/// Restore world to its state after load
+#define RESET           gap::msgs::WorldUtilsRequest::RESET
+/// Remove or reset request completed
+#define REMOVED         gap::msgs::WorldUtilsResponse::REMOVED
+/// Spawn request completed
+#define SPAWNED         gap::msgs::WorldUtilsResponse::SPAWNED
+/// Move request completed
+#define WORLD_MOVED     gap::msgs::WorldUtilsResponse::MOVED
 
 /// Spawn custom object
 #define CUSTOM          gap::msgs::Object::CUSTOM
@@ -168,12 +209,61 @@ void addModelFromFile(
     gap::msgs::WorldUtilsRequest & msg,
     const std::string & file);
 
+/// \brief Adds SDF templates of dynamic objects to WorldUtils register request
+/// \param msg  WorldUtils request message
+void addTemplates(gap::msgs::WorldUtilsRequest & msg);
+
 /// \brief Add objects in global grid to WorldUtils spawn request
+///
+/// Objects are spawned from the templates registered with addTemplates
 /// \param msg  WorldUtils request message
 void addDynamicModels(gap::msgs::WorldUtilsRequest & msg);
 
-/// \brief Add objects in global grid to VisualUtils update request
-void updateObjects(gap::msgs::VisualUtilsRequest & msg);
+/// \brief Prepares scenes ahead of rendering
+///
+/// Populates the global grid and builds plugin requests for each scene
+/// \param queue    Output queue of prepared scenes
+/// \param info     Camera image properties and intrinsics
+/// \param start    Index of the first scene
+/// \param scenes   Number of scenes to prepare
+/// \param seed     Random seed
+void prepareScenes(
+    SceneQueue & queue,
+    const gap::msgs::CameraInfo & info,
+    const unsigned int start,
+    const unsigned int scenes,
+    const uint64_t seed);
+
+/// \brief Stores annotations of rendered scenes
+/// \param queue    Input queue of rendered scenes
+/// \param path     Path to dataset folder
+/// \param binary   Whether to append annotations to binary files, rather
+///                 than write one XML file per scene
+void writeScenes(
+    SceneQueue & queue,
+    const std::string & path,
+    const bool binary);
+
+/// \brief Add scene objects to VisualUtils update request
+///
+/// Materials are picked by catalog index, from the scene random stream
+/// \param msg      VisualUtils request message
+/// \param scene    Scene to render
+void updateObjects(gap::msgs::VisualUtilsRequest & msg, const Scene & scene);
+
+/// \brief Picks a random material catalog index for a visual
+/// \param name     Visual name
+/// \return Catalog index, or -1 for the plugin to pick one, if the
+///         catalog of the visual is unknown or empty
+int getRandomMaterialId(const std::string & name);
+
+/// \brief Obtains material catalog sizes of ground and dynamic objects
+///
+/// Visuals register as spawned models are rendered, possibly after the
+/// spawn is acknowledged, hence the request is repeated until every
+/// visual replies
+/// \param pub      VisualUtils publisher
+void requestCatalogs(gazebo::transport::PublisherPtr pub);
 
 /// \brief Add move object command to WorldUtils request
 /// \param msg      WordlUtils request
@@ -199,29 +289,28 @@ ignition::math::Pose3d getRandomLightPose();
 /// \param iteration    Current iteration
 void captureScene(gazebo::transport::PublisherPtr pub, int iteration);
 
-/// \brief Wait for camera to move to new pose
-/// \return True if process should wait
-bool waitForMove();
-
-/// \brief Wait for visuals to update
-/// \return True if process should wait
-bool waitForVisuals();
-
-/// \brief Wait for camera to save frame to disk
-/// \return True if process should wait
-bool waitForCamera();
-
-/// \brief Wait for projected points
-bool waitForProjections();
+/// \brief Wait for plugin response, exiting on timeout
+/// \param event    Synchronization event
+/// \param id       Request id, or Synchronizer::ANY
+/// \param what     Description of the awaited response, for error output
+void waitFor(const int event, const unsigned int id, const std::string & what);
 
 /// \brief Create set with names of existing objects
-void createNameSet();
-
-/// \brief Add 3D points to projection request
-void addProjections(gap::msgs::CameraUtilsRequest & msg);
-
-/// \brief Move camera to global camera pose
-void moveCamera(gazebo::transport::PublisherPtr pub);
+/// \warning Caller must hold g_scene_mutex
+/// \param scene    Scene being rendered
+void createNameSet(const Scene & scene);
+
+/// \brief Obtains object bounding box from projection of its surface points
+/// \param camera   Camera projector, at the scene camera pose
+/// \param object   Object, whose bounding box is set
+void projectSurface(const CameraProjector & camera, Object & object);
+
+/// \brief Move camera to given pose
+/// \param pub  CameraUtils publisher ptr
+/// \param pose New camera pose
+void moveCamera(
+    gazebo::transport::PublisherPtr pub,
+    const ignition::math::Pose3d & pose);
 
 /// \brief Callback function for CameraUtils response
 /// \param _msg Incoming message
@@ -244,9 +333,19 @@ void setPhysics(gazebo::transport::PublisherPtr pub, bool enable);
 /// Debug function to visualise acquired frame and object bounding boxes
 void visualizeData(const std::string & image_dir, int iteration);
 
-/// \brief Store current scene annotations
+/// \brief Obtains annotation of a rendered scene
+/// \param scene    Rendered scene
+/// \return Scene annotation
+SceneAnnotation annotate(const Scene & scene);
+
+/// \brief Store scene annotations in Pascal VOC XML file
+///
+/// Annotations are written to a temporary file, which is then renamed,
+/// so that an existing XML file is always complete, even if the client
+/// is killed while writing
 /// \param path         Path to dataset folder
-/// \param iteration    Current iteration
-void storeAnnotations(
+/// \param annotation   Scene annotation
+/// \return Whether annotations were stored
+bool storeAnnotations(
     const std::string & path,
-    const int iteration);
+    const SceneAnnotation & annotation);
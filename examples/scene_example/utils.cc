@@ -30,6 +30,9 @@ const std::string getUsage(const char* argv_0)
         "usage:   " + std::string(argv_0) + " [options]\n" +
         "options: -s <number of scenes to generate>\n"  +
         "         -n <index of the first scene>\n" +
+        "         -p <pipeline depth>\n" +
+        "         -b (write binary annotations)\n" +
+        "         -g <random seed>\n" +
         "         -i <image output directory>\n" +
         "         -d <dataset output directory>\n";
 }
@@ -40,14 +43,17 @@ void parseArgs(
     char** argv,
     unsigned int & scenes,
     unsigned int & start,
+    unsigned int & depth,
+    bool & binary,
+    uint64_t & seed,
     std::string & imgs_dir,
     std::string & dataset_dir)
 {
 
     int opt;
-    bool s, n, i, m, d;
+    bool s {false}, n {false}, p {false}, g {false}, i {false}, d {false};
 
-    while ((opt = getopt(argc,argv,"s: n: i: d:")) != EOF)
+    while ((opt = getopt(argc,argv,"s: n: p: b g: i: d:")) != EOF)
     {
         switch (opt)
         {
@@ -55,6 +61,12 @@ void parseArgs(
                 s = true; scenes = atoi(optarg); break;
             case 'n':
                 n = true; start = atoi(optarg); break;
+            case 'p':
+                p = true; depth = atoi(optarg); break;
+            case 'b':
+                binary = true; break;
+            case 'g':
+                g = true; seed = strtoull(optarg, nullptr, 10); break;
             case 'i':
                 i = true; imgs_dir = optarg;    break;
             case 'd':
@@ -70,11 +82,15 @@ void parseArgs(
     // If arg was not set then assign default values
     if (!s) scenes  = ARG_SCENES_DEFAULT;
     if (!n) start   = ARG_START_DEFAULT;
+    if (!p || depth == 0) depth = ARG_DEPTH_DEFAULT;
+    if (!g) seed = std::random_device{}();
     if (!i) imgs_dir    = ARG_IMGS_DIR_DEFAULT;
     if (!d) dataset_dir = ARG_DATASET_DIR_DEFAULT;
 
     debugPrint("Parameters:\n" <<
         "   scenes:      '" << scenes << "'\n"
+        "   depth:       '" << depth << "'\n"
+        "   seed:        '" << seed << "'\n"
         "   images dir:  '" << imgs_dir << "'\n"
         "   dataset dir: '" << dataset_dir <<  "'\n");
 }
@@ -102,27 +118,29 @@ bool createDirectory(std::string & path)
 
 //////////////////////////////////////////////////
 
-// Random integer generator
-std::random_device rng;
-std::mt19937 mt_rng(rng());
-std::uniform_int_distribution<int> uniform_dist;
+// Random number generator of each thread
+thread_local Philox t_rng;
+
+//////////////////////////////////////////////////
+void seedRandom(const uint64_t seed, const uint64_t stream)
+{
+    t_rng.seed(seed, stream);
+}
 
 //////////////////////////////////////////////////
 int getRandomInt(int min, int max)
 {
-    int aux = uniform_dist(mt_rng);
-    return aux % (max - min + 1) + min;;
+    return uniformInt(t_rng, min, max);
 }
 
 //////////////////////////////////////////////////
 double getRandomDouble(double min, double max)
 {
-    double aux = ((double) uniform_dist(mt_rng)) / (double) RAND_MAX;
-    return aux * (max - min) + min;
+    return uniformReal(t_rng, min, max);
 }
 
 //////////////////////////////////////////////////
 void shuffleIntVector(std::vector<int> & vector)
 {
-    std::shuffle(vector.begin(), vector.end(), mt_rng);
+    shuffle(t_rng, vector);
 }
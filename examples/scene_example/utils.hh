@@ -34,8 +34,10 @@
 #include <iostream>
 // File system
 #include <boost/filesystem.hpp>
-// Random
+// Random seed
 #include <random>
+// Counter-based random number generation
+#include "Random.hh"
 
 // Custom debug utilities
 #include "debug.hh"
@@ -48,6 +50,8 @@
 #define ARG_SCENES_DEFAULT      10
 /// Default index of the first scene
 #define ARG_START_DEFAULT       0
+/// Default pipeline depth
+#define ARG_DEPTH_DEFAULT       2
 /// Default image directory
 #define ARG_IMGS_DIR_DEFAULT    "imgs"
 /// Default dataset directory
@@ -64,6 +68,9 @@ const std::string getUsage(const char* argv_0);
 /// \param argv         Argument values
 /// \param scenes       Number of scenes to generate
 /// \param start        Index of the first scene
+/// \param depth        Scenes each pipeline stage may run ahead of the next
+/// \param binary       Whether to write annotations to binary files
+/// \param seed         Random seed, drawn from random_device if not given
 /// \param imgs_dir     Image output directory
 /// \param dataset_dir  Dataset annotations output directory
 void parseArgs(
@@ -71,6 +78,9 @@ void parseArgs(
     char** argv,
     unsigned int & scenes,
     unsigned int & start,
+    unsigned int & depth,
+    bool & binary,
+    uint64_t & seed,
     std::string & imgs_dir,
     std::string & dataset_dir);
 
@@ -79,12 +89,20 @@ void parseArgs(
 /// \return true on success
 bool createDirectory(std::string & path);
 
+/// \brief Restarts random number generator of the calling thread
+///
+/// Each thread has its own generator, whose output only depends on the
+/// seed and stream id it was last given
+/// \param seed     Random seed
+/// \param stream   Stream id, such as the index of the scene being prepared
+void seedRandom(const uint64_t seed, const uint64_t stream);
+
 /// \brief Get a random integer in a given interval
 ///
-/// Value is sampled from uniform distribution
+/// Value is sampled from uniform distribution, without modulo bias
 ///
 /// \param min Interval lower bound
-/// \param max Interval upper bound
+/// \param max Interval upper bound, inclusive
 /// \return Random integer
 int getRandomInt(int min, int max);
 
@@ -93,7 +111,7 @@ int getRandomInt(int min, int max);
 /// Value is sampled from uniform distribution
 ///
 /// \param min Interval lower bound
-/// \param max Interval upper bound
+/// \param max Interval upper bound, exclusive
 /// \return Random double
 double getRandomDouble(double min, double max);
 
@@ -180,6 +180,28 @@ void CameraUtils::onRequest(CameraUtilsRequestPtr &_msg)
         }
         this->dataPtr->pub->Publish(msg);
     }
+    else if (_msg->type() == INFO_REQUEST)
+    {
+        gap::msgs::CameraUtilsResponse msg;
+        msg.set_type(INFO_RESPONSE);
+
+        gap::msgs::CameraInfo *info = msg.mutable_info();
+        info->set_width(this->width);
+        info->set_height(this->height);
+        info->set_depth(this->depth);
+        info->set_format(this->format);
+        info->set_hfov(this->camera->HFOV().Radian());
+        info->set_near_clip(this->camera->NearClip());
+        info->set_far_clip(this->camera->FarClip());
+        // Same matrix used by Camera::Project
+        ignition::math::Matrix4d projection = this->camera->ProjectionMatrix();
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                info->add_projection_matrix(projection(i, j));
+            }
+        }
+        this->dataPtr->pub->Publish(msg);
+    }
     else if (_msg->type() == MOVE_REQUEST)
     {
     	gap::msgs::CameraUtilsResponse msg;
@@ -63,6 +63,10 @@ namespace CameraUtils {
 #define PROJECTION_REQUEST  gap::msgs::CameraUtilsRequest::PROJECTION
 /// Point projection response
 #define PROJECTION_RESPONSE gap::msgs::CameraUtilsResponse::PROJECTION
+/// Request camera image properties and intrinsics
+#define INFO_REQUEST        gap::msgs::CameraUtilsRequest::INFO
+/// Camera image properties and intrinsics response
+#define INFO_RESPONSE       gap::msgs::CameraUtilsResponse::INFO
 
 // Default parameters
 
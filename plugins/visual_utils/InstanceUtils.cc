@@ -0,0 +1,307 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file visual_utils/InstanceUtils.cc
+    \brief Instance Utils plugin implementation
+
+    A custom gazebo plugin that manages a pool of primitive visuals,
+    updated in bulk from a single packed request.
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "InstanceUtils.hh"
+
+namespace gazebo {
+
+/// Number of primitive shapes
+static const int NUM_SHAPES = 3;
+/// Name of each primitive shape
+static const char *SHAPE_NAMES[NUM_SHAPES] = {"sphere", "cylinder", "box"};
+/// Unit mesh of each primitive shape
+static const char *SHAPE_MESHES[NUM_SHAPES] =
+    {"unit_sphere", "unit_cylinder", "unit_box"};
+
+/// \brief Class for private instance utils plugin data.
+class InstanceUtilsPrivate
+{
+    /// Visual to which the plugin is attached
+    public: rendering::VisualPtr visual;
+    /// Connects to rendering update event
+    public: event::ConnectionPtr updateConnection;
+    /// Gazebo transport node
+    public: transport::NodePtr node;
+    /// Instance utils topic subscriber
+    public: transport::SubscriberPtr sub;
+    /// A publisher to the reply topic
+    public: transport::PublisherPtr pub;
+
+    /// Pool of instances, one per shape
+    public: std::vector<rendering::VisualPtr> pool[NUM_SHAPES];
+    /// Material applied to each pooled instance, one per shape
+    public: std::vector<int> pool_materials[NUM_SHAPES];
+    /// Maximum number of instances
+    public: unsigned int max_instances {DEFAULT_MAX_INSTANCES};
+
+    /// Material name patterns
+    public: std::vector<std::string> patterns;
+    /// Available materials, sorted by name
+    public: std::vector<std::string> materials;
+    /// Shuffled indices of available materials
+    public: std::vector<unsigned int> random_order;
+    /// Internal counter for used materials
+    public: unsigned int used_materials {0};
+
+    /// Pending requests, in order of arrival
+    public: std::vector<boost::shared_ptr<const gap::msgs::InstanceUtilsRequest>>
+        msgs;
+    /// Mutex
+    public: std::mutex mutex;
+};
+
+/// Register this plugin with the simulator
+GZ_REGISTER_VISUAL_PLUGIN(InstanceUtils)
+
+/////////////////////////////////////////////////
+InstanceUtils::InstanceUtils(): VisualPlugin(),
+    dataPtr(new InstanceUtilsPrivate)
+{
+}
+
+/////////////////////////////////////////////////
+InstanceUtils::~InstanceUtils()
+{
+    dataPtr->updateConnection.reset();
+    dataPtr->sub.reset();
+    if (dataPtr->node) {
+        dataPtr->node->Fini();
+    }
+    for (int s = 0; s < NUM_SHAPES; s++)
+    {
+        for (unsigned int i = 0; i < dataPtr->pool[s].size(); i++)
+        {
+            int material = dataPtr->pool_materials[s][i];
+            if (material >= 0) {
+                MaterialCache::instance().release(
+                    dataPtr->materials.at(material));
+            }
+            dataPtr->pool[s][i]->Fini();
+        }
+    }
+    gzmsg << "[InstanceUtils] Unloaded instance tools." << std::endl;
+}
+
+/////////////////////////////////////////////////
+void InstanceUtils::Load(rendering::VisualPtr _visual, sdf::ElementPtr _sdf)
+{
+    // Check if attached to valid visual
+    if (!_visual || !_sdf) {
+        gzerr << "[InstanceUtils] Invalid visual or SDF element." << std::endl;
+        return;
+    }
+    dataPtr->visual = _visual;
+
+    // Plugin parameters
+
+    // Possible patterns for material names
+    if (_sdf->HasElement("patterns")) {
+        std::string patterns_arg(_sdf->Get<std::string>("patterns"));
+        boost::split(dataPtr->patterns, patterns_arg,
+            boost::is_any_of(" "), boost::token_compress_on);
+    }
+    // Maximum number of instances
+    if (_sdf->HasElement("max_instances")) {
+        dataPtr->max_instances = _sdf->Get<unsigned int>("max_instances");
+    }
+
+    // Load materials
+    dataPtr->materials = MaterialCache::catalog(dataPtr->patterns);
+    dataPtr->random_order.resize(dataPtr->materials.size());
+    std::iota(dataPtr->random_order.begin(), dataPtr->random_order.end(), 0);
+    if (_sdf->HasElement("preload") && _sdf->Get<bool>("preload")) {
+        MaterialCache::instance().preload(dataPtr->materials);
+    }
+
+    // Connect to the render update signal
+    dataPtr->updateConnection = event::Events::ConnectPreRender(
+        std::bind(&InstanceUtils::Update, this));
+    // Setup transport node
+    dataPtr->node = transport::NodePtr(new transport::Node());
+    dataPtr->node->Init();
+    // Subcribe to the monitored requests topic
+    dataPtr->sub = dataPtr->node->Subscribe(REQUEST_TOPIC,
+        &InstanceUtils::onRequest, this);
+    // Setup publisher for the response topic
+    dataPtr->pub = dataPtr->node->
+        Advertise<gap::msgs::InstanceUtilsResponse>(RESPONSE_TOPIC);
+
+    gzmsg << "[InstanceUtils] Loaded instance tools." << std::endl;
+}
+
+/////////////////////////////////////////////////
+void InstanceUtils::Update()
+{
+    std::vector<boost::shared_ptr<const gap::msgs::InstanceUtilsRequest>> msgs;
+    {
+        std::lock_guard<std::mutex> lock(dataPtr->mutex);
+        if (dataPtr->msgs.empty()) { return; }
+        msgs.swap(dataPtr->msgs);
+    }
+
+    // Requests received since the last frame are applied in order, so that
+    // each is answered, and the frame shows the latest one
+    for (const auto & msg : msgs) {
+        apply(*msg);
+    }
+}
+
+/////////////////////////////////////////////////
+void InstanceUtils::apply(const gap::msgs::InstanceUtilsRequest & _msg)
+{
+    gap::msgs::InstanceUtilsResponse response;
+    unsigned int used[NUM_SHAPES] = {0};
+
+    for (int i = 0; i < _msg.shape_size(); i++)
+    {
+        int shape = _msg.shape(i) - 1;
+        if (shape < 0 || shape >= NUM_SHAPES) {
+            // Keep response aligned with request indices
+            response.add_material(-1);
+            continue;
+        }
+        rendering::VisualPtr visual = instance(shape, used[shape]);
+        if (!visual) {
+            gzwarn << "[InstanceUtils] Instance pool is full." << std::endl;
+            break;
+        }
+
+        // Pose, as x y z qw qx qy qz
+        if (_msg.pose_size() >= 7 * (i + 1)) {
+            const double *p = _msg.pose().data() + 7 * i;
+            visual->SetWorldPose(ignition::math::Pose3d(
+                p[0], p[1], p[2], p[3], p[4], p[5], p[6]));
+        }
+        // Scale, as x y z
+        if (_msg.scale_size() >= 3 * (i + 1)) {
+            const double *s = _msg.scale().data() + 3 * i;
+            visual->SetScale(ignition::math::Vector3d(s[0], s[1], s[2]));
+        }
+        // Material
+        int requested = (i < _msg.material_size())? _msg.material(i) : -1;
+        int material = materialIndex(requested);
+        int & current = dataPtr->pool_materials[shape][used[shape]];
+        if (material >= 0 && material != current)
+        {
+            const std::string & name = dataPtr->materials.at(material);
+            MaterialCache::instance().acquire(name);
+            if (current >= 0) {
+                MaterialCache::instance().release(
+                    dataPtr->materials.at(current));
+            }
+            visual->SetMaterial(name, false, false);
+            current = material;
+        }
+        visual->SetVisible(true);
+        response.add_material(current);
+        used[shape]++;
+    }
+
+    // Hide every unused instance
+    int count = 0;
+    for (int s = 0; s < NUM_SHAPES; s++)
+    {
+        count += used[s];
+        for (unsigned int j = used[s]; j < dataPtr->pool[s].size(); j++) {
+            dataPtr->pool[s][j]->SetVisible(false);
+        }
+    }
+
+    response.set_type(UPDATED);
+    response.set_count(count);
+    dataPtr->pub->Publish(response);
+}
+
+/////////////////////////////////////////////////
+void InstanceUtils::onRequest(InstanceUtilsRequestPtr &_msg)
+{
+    // Validate msg structure
+    if (!_msg->has_type() || _msg->type() != UPDATE) {
+        gzwarn <<" [InstanceUtils] Invalid request received" << std::endl;
+        return;
+    }
+
+    // Queue request, as several may arrive before the next frame
+    std::lock_guard<std::mutex> lock(dataPtr->mutex);
+    dataPtr->msgs.push_back(_msg);
+}
+
+/////////////////////////////////////////////////
+rendering::VisualPtr InstanceUtils::instance(int shape, unsigned int index)
+{
+    std::vector<rendering::VisualPtr> & pool = dataPtr->pool[shape];
+    if (index < pool.size()) {
+        return pool[index];
+    }
+
+    unsigned int total = 0;
+    for (int s = 0; s < NUM_SHAPES; s++) {
+        total += dataPtr->pool[s].size();
+    }
+    if (total >= dataPtr->max_instances) {
+        return rendering::VisualPtr();
+    }
+
+    // Create new instance sharing the unit mesh of its shape
+    rendering::ScenePtr scene = dataPtr->visual->GetScene();
+    std::string name = "instance_utils::" +
+        std::string(SHAPE_NAMES[shape]) + "_" + std::to_string(index);
+    rendering::VisualPtr visual(
+        new rendering::Visual(name, scene->WorldVisual()));
+    visual->Load();
+    visual->AttachMesh(SHAPE_MESHES[shape]);
+    visual->SetCastShadows(true);
+    visual->SetLighting(true);
+
+    pool.push_back(visual);
+    dataPtr->pool_materials[shape].push_back(-1);
+    return visual;
+}
+
+/////////////////////////////////////////////////
+int InstanceUtils::materialIndex(int requested)
+{
+    unsigned int total = dataPtr->materials.size();
+    if (requested >= 0 && static_cast<unsigned int>(requested) < total) {
+        return requested;
+    }
+    if (total == 0) {
+        return -1;
+    }
+    if (dataPtr->used_materials == total || dataPtr->used_materials == 0)
+    {
+        // All materials have been used once. Reshuffle
+        unsigned int seed =
+            std::chrono::system_clock::now().time_since_epoch().count();
+        auto rng = std::mt19937 {seed};
+        std::shuffle(std::begin(dataPtr->random_order),
+            std::end(dataPtr->random_order), rng);
+        dataPtr->used_materials = 0;
+    }
+    return dataPtr->random_order.at(dataPtr->used_materials++);
+}
+
+}
@@ -0,0 +1,152 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file visual_utils/InstanceUtils.hh
+    \brief Instance Utils plugin
+
+    A custom gazebo plugin that manages a pool of primitive visuals,
+    updated in bulk from a single packed request.
+
+    \author João Borrego : jsbruglie
+*/
+
+// Gazebo
+#include <gazebo/common/Events.hh>
+#include "gazebo/common/Plugin.hh"
+#include <gazebo/msgs/msgs.hh>
+#include <gazebo/rendering/Scene.hh>
+#include <gazebo/rendering/Visual.hh>
+#include <gazebo/transport/Node.hh>
+
+// Boost - for convenient string split
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+// Mutex
+#include <mutex>
+// Shuffle vector
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <chrono>
+
+// Custom messages
+#include "instance_utils_request.pb.h"
+#include "instance_utils_response.pb.h"
+
+// Shared cache of loaded materials
+#include "MaterialCache.hh"
+
+namespace InstanceUtils {
+
+/// Topic monitored for incoming commands
+#define REQUEST_TOPIC   "~/gap/instance_utils"
+/// Topic for publishing replies
+#define RESPONSE_TOPIC  "~/gap/instance_utils/response"
+
+/// Request update
+#define UPDATE          gap::msgs::InstanceUtilsRequest::UPDATE
+/// Instances updated response
+#define UPDATED         gap::msgs::InstanceUtilsResponse::UPDATED
+
+// Default parameters
+
+/// Default maximum number of instances
+#define DEFAULT_MAX_INSTANCES   1000
+
+}
+
+namespace gazebo{
+
+    /// Shared pointer declaration for request message type
+    typedef const boost::shared_ptr<const gap::msgs::InstanceUtilsRequest>
+        InstanceUtilsRequestPtr;
+    /// Shared pointer declaration for response message type
+    typedef const boost::shared_ptr<const gap::msgs::InstanceUtilsResponse>
+        InstanceUtilsResponsePtr;
+
+    // Forward declaration of private data class
+    class InstanceUtilsPrivate;
+
+    /// \brief A custom gazebo plugin that manages a pool of primitive visuals
+    ///
+    /// Spheres, cylinders and boxes are created on demand as children of the
+    /// world visual, sharing the unit meshes of each primitive type.
+    /// Each request carries packed arrays with the shape, pose, scale and
+    /// material of every instance, which are applied in a single rendered
+    /// frame. Pooled instances not included in a request are hidden.
+    /// Every request is answered with an UPDATED response, even if a later
+    /// one arrives before the next frame and replaces it on screen.
+    /// Entries with an invalid shape are skipped, and report material -1.
+    /// Once the pool is full, the remaining entries are dropped, so the
+    /// response has fewer materials than the request.
+    /// A single transport node serves every instance.
+    ///
+    /// See the example usage below:
+    ///
+    /// \code{.xml}
+    ///    <plugin name="instance_utils" filename="libInstanceUtils.so">
+    ///     <!-- Prefix patterns for material names, separated by whitespace -->
+    ///     <patterns>Plugin/flat_ Plugin/gradient_ ... </patterns>
+    ///     <!-- Optional: maximum number of instances -->
+    ///     <max_instances>5000</max_instances>
+    ///     <!-- Optional: load matching materials ahead of time -->
+    ///     <preload>true</preload>
+    ///    </plugin>
+    /// \endcode
+    ///
+    /// The plugin may be attached to any visual, e.g. the ground plane.
+    class InstanceUtils : public VisualPlugin {
+
+        /// \brief Constructs the object
+        public: InstanceUtils();
+
+        /// \brief Destroys the object
+        public: virtual ~InstanceUtils();
+
+        /// \brief Loads the plugin
+        /// \param _visual  The visual to which the plugin is attached
+        /// \param _sdf     The SDF element with plugin parameters
+        public: virtual void Load(
+            rendering::VisualPtr _visual,
+            sdf::ElementPtr _sdf);
+
+        /// \brief Update once per rendered frame
+        public: void Update();
+
+        /// \brief Callback function for handling incoming requests
+        /// \param _msg  The message
+        public: void onRequest(InstanceUtilsRequestPtr & _msg);
+
+        /// \brief Private data pointer
+        private: std::unique_ptr<InstanceUtilsPrivate> dataPtr;
+
+        /// \brief Applies a request to the pool and publishes its response
+        /// \param _msg  The request
+        private: void apply(const gap::msgs::InstanceUtilsRequest & _msg);
+
+        /// \brief Obtains a pooled instance, creating it if required
+        /// \param shape    Instance shape index
+        /// \param index    Instance index within shape pool
+        /// \return Instance visual, or null pointer if pool is full
+        private: rendering::VisualPtr instance(int shape, unsigned int index);
+
+        /// \brief Obtains material catalog index for an instance
+        /// \param requested    Requested catalog index, negative for random
+        /// \return Catalog index, or -1 if no materials are available
+        private: int materialIndex(int requested);
+    };
+}
@@ -0,0 +1,209 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file visual_utils/MaterialCache.cc
+    \brief Material Cache class implementation
+
+    Process-wide cache of loaded OGRE materials, shared by every
+    VisualUtils and InstanceUtils plugin instance.
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "MaterialCache.hh"
+
+/////////////////////////////////////////////////
+MaterialCache & MaterialCache::instance()
+{
+    static MaterialCache cache;
+    return cache;
+}
+
+/////////////////////////////////////////////////
+std::vector<std::string> MaterialCache::catalog(
+    const std::vector<std::string> & _patterns)
+{
+    std::vector<std::string> materials;
+
+    // Get list of OGRE resources
+    Ogre::ResourceManager::ResourceMapIterator resources =
+        Ogre::MaterialManager::getSingleton().getResourceIterator();
+    // Add materials that match material patterns
+    for (auto & material : resources)
+    {
+        const std::string & name = material.second->getName();
+        for (auto & pattern : _patterns)
+        {
+            // Check if pattern matches prefix
+            if (!pattern.empty() &&
+                name.compare(0, pattern.size(), pattern) == 0) {
+                materials.push_back(name);
+                break;
+            }
+        }
+    }
+
+    std::sort(materials.begin(), materials.end());
+    materials.erase(std::unique(materials.begin(), materials.end()),
+        materials.end());
+    return materials;
+}
+
+/////////////////////////////////////////////////
+void MaterialCache::setCapacity(unsigned int _capacity)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = _capacity;
+    evict();
+}
+
+/////////////////////////////////////////////////
+void MaterialCache::preload(const std::vector<std::string> & _names)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto & name : _names)
+    {
+        if (capacity && entries.size() >= capacity) {
+            break;
+        }
+        if (entries.find(name) == entries.end()) {
+            load(name);
+        }
+    }
+}
+
+/////////////////////////////////////////////////
+void MaterialCache::acquire(const std::string & _name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto entry = load(_name);
+    if (entry != entries.end()) {
+        entry->second.users++;
+        evict();
+    }
+}
+
+/////////////////////////////////////////////////
+void MaterialCache::release(const std::string & _name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto entry = entries.find(_name);
+    if (entry != entries.end() && entry->second.users > 0) {
+        entry->second.users--;
+    }
+}
+
+/////////////////////////////////////////////////
+std::map<std::string, MaterialCache::Entry>::iterator MaterialCache::load(
+    const std::string & _name)
+{
+    auto entry = entries.find(_name);
+    if (entry != entries.end())
+    {
+        // Already loaded, move to front of list
+        lru.splice(lru.begin(), lru, entry->second.it);
+        return entry;
+    }
+
+    Ogre::MaterialPtr material =
+        Ogre::MaterialManager::getSingleton().getByName(_name);
+    if (material.isNull()) {
+        gzwarn << "[MaterialCache] Material not found: " << _name << std::endl;
+        return entries.end();
+    }
+    // Compiles material and loads its textures to GPU
+    material->load();
+
+    lru.push_front(_name);
+    entry = entries.emplace(_name, Entry()).first;
+    entry->second.it = lru.begin();
+    entry->second.textures = textureNames(material);
+    for (const auto & texture : entry->second.textures) {
+        textures[texture]++;
+    }
+    return entry;
+}
+
+/////////////////////////////////////////////////
+void MaterialCache::evict()
+{
+    if (!capacity) { return; }
+
+    auto it = lru.end();
+    while (entries.size() > capacity && it != lru.begin())
+    {
+        --it;
+        auto entry = entries.find(*it);
+        if (entry->second.users > 0) {
+            continue;
+        }
+        unload(entry->first, entry->second);
+        it = lru.erase(it);
+        entries.erase(entry);
+    }
+}
+
+/////////////////////////////////////////////////
+void MaterialCache::unload(const std::string & _name, const Entry & _entry)
+{
+    Ogre::MaterialPtr material =
+        Ogre::MaterialManager::getSingleton().getByName(_name);
+    if (!material.isNull()) {
+        material->unload();
+    }
+
+    // Free memory of textures no other cached material refers to
+    for (const auto & texture : _entry.textures)
+    {
+        auto count = textures.find(texture);
+        if (count == textures.end() || --count->second > 0) {
+            continue;
+        }
+        textures.erase(count);
+        Ogre::TextureManager::getSingleton().unload(texture);
+    }
+}
+
+/////////////////////////////////////////////////
+std::vector<std::string> MaterialCache::textureNames(
+    const Ogre::MaterialPtr & _material)
+{
+    std::vector<std::string> names;
+    Ogre::Material::TechniqueIterator techniques =
+        _material->getTechniqueIterator();
+    while (techniques.hasMoreElements())
+    {
+        Ogre::Technique::PassIterator passes =
+            techniques.getNext()->getPassIterator();
+        while (passes.hasMoreElements())
+        {
+            Ogre::Pass::TextureUnitStateIterator units =
+                passes.getNext()->getTextureUnitStateIterator();
+            while (units.hasMoreElements())
+            {
+                const std::string & texture = units.getNext()->getTextureName();
+                if (!texture.empty()) {
+                    names.push_back(texture);
+                }
+            }
+        }
+    }
+
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
@@ -0,0 +1,127 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file visual_utils/MaterialCache.hh
+    \brief Material Cache class
+
+    Process-wide cache of loaded OGRE materials, shared by every
+    VisualUtils and InstanceUtils plugin instance.
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _MATERIAL_CACHE_HH_
+#define _MATERIAL_CACHE_HH_
+
+// Gazebo
+#include "gazebo/common/Console.hh"
+#include "gazebo/rendering/ogre_gazebo.h"
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// \brief Process-wide cache of loaded OGRE materials
+///
+/// Materials are loaded, and their textures uploaded, ahead of time rather
+/// than on first use in the render loop.
+/// When a capacity is set, the least recently used materials which are not
+/// applied to any visual are unloaded, along with the textures no other
+/// cached material refers to.
+///
+/// \warning Should only be used from the rendering thread.
+class MaterialCache
+{
+    /// \brief Loaded material entry
+    private: struct Entry
+    {
+        /// Position in least recently used list
+        std::list<std::string>::iterator it;
+        /// Number of visuals currently using the material
+        unsigned int users {0};
+        /// Names of textures referred to by the material
+        std::vector<std::string> textures;
+    };
+
+    /// Names of loaded materials, most recently used first
+    private: std::list<std::string> lru;
+    /// Loaded materials, indexed by name
+    private: std::map<std::string, Entry> entries;
+    /// Number of loaded materials referring to each texture
+    private: std::map<std::string, unsigned int> textures;
+    /// Maximum number of loaded materials, 0 for unlimited
+    private: unsigned int capacity {0};
+    /// Mutex for safe data access
+    private: std::mutex mutex;
+
+    /// \brief Obtains the shared instance
+    /// \return Process-wide material cache
+    public: static MaterialCache & instance();
+
+    /// \brief Obtains names of available materials matching given prefixes
+    /// \param _patterns   Prefix patterns for material names
+    /// \return Sorted names of matching materials
+    public: static std::vector<std::string> catalog(
+        const std::vector<std::string> & _patterns);
+
+    /// \brief Sets the maximum number of loaded materials
+    /// \param _capacity Maximum number of materials, 0 for unlimited
+    public: void setCapacity(unsigned int _capacity);
+
+    /// \brief Loads a set of materials ahead of time
+    ///
+    /// Stops once capacity is reached, if one is set.
+    ///
+    /// \param _names Names of materials to load
+    public: void preload(const std::vector<std::string> & _names);
+
+    /// \brief Marks a material as used by a visual, loading it if required
+    /// \param _name Material name
+    public: void acquire(const std::string & _name);
+
+    /// \brief Marks a material as no longer used by a visual
+    /// \param _name Material name
+    public: void release(const std::string & _name);
+
+    /// \brief Constructs the object
+    private: MaterialCache() = default;
+
+    /// \brief Loads a material and registers it as most recently used
+    /// \param _name Material name
+    /// \return Iterator to cache entry, or end iterator on failure
+    private: std::map<std::string, Entry>::iterator load(
+        const std::string & _name);
+
+    /// \brief Unloads least recently used materials not in use
+    private: void evict();
+
+    /// \brief Unloads a material and the textures only it referred to
+    /// \param _name   Material name
+    /// \param _entry  Cache entry of the material
+    private: void unload(const std::string & _name, const Entry & _entry);
+
+    /// \brief Obtains names of textures referred to by a material
+    /// \param _material Material
+    /// \return Sorted names of textures, without duplicates
+    private: static std::vector<std::string> textureNames(
+        const Ogre::MaterialPtr & _material);
+};
+
+#endif
@@ -0,0 +1,297 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file visual_utils/VisualScene.cc
+    \brief Visual Scene class implementation
+
+    Double-buffered scene state shared by every VisualUtils plugin instance,
+    so that each request is applied to all visuals in a single frame.
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "VisualUtils.hh"
+
+namespace gazebo {
+
+/////////////////////////////////////////////////
+void VisualState::merge(const VisualState & _newer)
+{
+    if (_newer.update_pose) {
+        pose = _newer.pose;
+        update_pose = true;
+    }
+    if (_newer.update_scale) {
+        scale = _newer.scale;
+        update_scale = true;
+    }
+    if (_newer.update_material) {
+        material = _newer.material;
+        update_material = true;
+    }
+}
+
+/////////////////////////////////////////////////
+VisualScene & VisualScene::instance()
+{
+    static VisualScene scene;
+    return scene;
+}
+
+/////////////////////////////////////////////////
+void VisualScene::registerVisual(VisualUtils * _plugin)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (visuals.empty())
+    {
+        // Connect to the render update signal
+        updateConnection = event::Events::ConnectPreRender(
+            std::bind(&VisualScene::onUpdate, this));
+        // Setup transport node
+        node = transport::NodePtr(new transport::Node());
+        node->Init();
+        // Subcribe to the monitored requests topic
+        sub = node->Subscribe(REQUEST_TOPIC, &VisualScene::onRequest, this);
+        // Setup publisher for the response topic
+        pub = node->Advertise<gap::msgs::VisualUtilsResponse>(RESPONSE_TOPIC);
+    }
+    visuals.insert(_plugin);
+}
+
+/////////////////////////////////////////////////
+void VisualScene::unregisterVisual(VisualUtils * _plugin)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    visuals.erase(_plugin);
+    front.erase(_plugin);
+    back.erase(_plugin);
+    for (auto & request : back_requests) {
+        request.erase(std::remove(request.begin(), request.end(), _plugin),
+            request.end());
+    }
+
+    if (visuals.empty())
+    {
+        updateConnection.reset();
+        sub.reset();
+        pub.reset();
+        node->Fini();
+        node.reset();
+        back_colors.clear();
+        back_requests.clear();
+        back_color_requests.clear();
+        pending = false;
+    }
+}
+
+/////////////////////////////////////////////////
+void VisualScene::onRequest(VisualUtilsRequestPtr &_msg)
+{
+    // Validate msg structure
+    if (!_msg->has_type()) {
+        gzwarn <<" [VisualUtils] Invalid request received" << std::endl;
+        return;
+    }
+    if (_msg->type() == COLOR) {
+        onColorRequest(_msg);
+        return;
+    }
+    if (_msg->type() == CATALOG) {
+        onCatalogRequest(_msg);
+        return;
+    }
+
+    // Index of each target in request
+    std::map<std::string, int> targets;
+    for (int i = _msg->targets_size() - 1; i >= 0; i--) {
+        targets[_msg->targets(i)] = i;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Merge next state with any pending state not yet rendered
+    std::vector<VisualUtils *> updated;
+    for (auto & visual : visuals)
+    {
+        auto target = targets.find(visual->uid());
+        int index = (target != targets.end())? target->second : -1;
+
+        VisualState state;
+        if (visual->onRequest(_msg, index, state)) {
+            back[visual].merge(state);
+            updated.push_back(visual);
+        }
+    }
+
+    if (!updated.empty()) {
+        back_requests.push_back(std::move(updated));
+        pending = true;
+    }
+}
+
+/////////////////////////////////////////////////
+void VisualScene::onColorRequest(VisualUtilsRequestPtr &_msg)
+{
+    // Optional server-side sampling of colors
+    std::mt19937 rng(_msg->seed());
+    std::uniform_real_distribution<float> dist(0.0, 1.0);
+
+    std::vector<ColorState> colors(_msg->targets_size());
+    for (int i = 0; i < _msg->targets_size(); i++)
+    {
+        ColorState & state = colors[i];
+        state.name = _msg->targets(i);
+        if (i < _msg->ambient_size()) {
+            state.ambient = msgs::Convert(_msg->ambient(i));
+            state.update_ambient = true;
+        }
+        if (i < _msg->diffuse_size()) {
+            state.diffuse = msgs::Convert(_msg->diffuse(i));
+            state.update_diffuse = true;
+        }
+        if (i < _msg->specular_size()) {
+            state.specular = msgs::Convert(_msg->specular(i));
+            state.update_specular = true;
+        }
+        if (i < _msg->emissive_size()) {
+            state.emissive = msgs::Convert(_msg->emissive(i));
+            state.update_emissive = true;
+        }
+        if (_msg->has_seed() && !state.update_ambient && !state.update_diffuse)
+        {
+            float r = dist(rng), g = dist(rng), b = dist(rng);
+            state.ambient.Set(r, g, b);
+            state.diffuse.Set(r, g, b);
+            state.update_ambient = state.update_diffuse = true;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    back_colors.insert(back_colors.end(), colors.begin(), colors.end());
+    back_color_requests.push_back(colors.size());
+    pending = true;
+}
+
+/////////////////////////////////////////////////
+void VisualScene::onCatalogRequest(VisualUtilsRequestPtr &_msg)
+{
+    std::set<std::string> targets(
+        _msg->targets().begin(), _msg->targets().end());
+
+    gap::msgs::VisualUtilsResponse msg;
+    msg.set_type(CATALOG_SIZES);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto & visual : visuals)
+    {
+        if (targets.empty() || targets.count(visual->uid())) {
+            msg.add_origin(visual->uid());
+            msg.add_catalog_size(visual->catalogSize());
+        }
+    }
+    pub->Publish(msg);
+}
+
+/////////////////////////////////////////////////
+void VisualScene::onUpdate()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!pending) { return; }
+        front.swap(back);
+        back.clear();
+        front_colors.swap(back_colors);
+        back_colors.clear();
+        front_requests.swap(back_requests);
+        back_requests.clear();
+        front_color_requests.swap(back_color_requests);
+        back_color_requests.clear();
+        pending = false;
+    }
+
+    // Apply every pending visual update in the current frame
+    for (auto & state : front) {
+        state.first->apply(state.second);
+    }
+    std::vector<bool> colored(front_colors.size());
+    for (std::size_t i = 0; i < front_colors.size(); i++) {
+        colored[i] = applyColors(front_colors[i]);
+    }
+
+    // Notify subscribers to the response topic that visuals were updated,
+    // once per request, reporting the material each visual now shows
+    for (const auto & request : front_requests)
+    {
+        gap::msgs::VisualUtilsResponse msg;
+        msg.set_type(UPDATED);
+        for (auto & visual : request)
+        {
+            const VisualState & state = front[visual];
+            msg.add_origin(visual->uid());
+            msg.add_material(state.update_material? state.material : "");
+        }
+        pub->Publish(msg);
+    }
+    std::size_t color = 0;
+    for (const auto & count : front_color_requests)
+    {
+        gap::msgs::VisualUtilsResponse msg;
+        msg.set_type(UPDATED);
+        for (std::size_t end = color + count; color < end; color++)
+        {
+            if (colored[color]) {
+                msg.add_origin(front_colors[color].name);
+                msg.add_material("");
+            }
+        }
+        pub->Publish(msg);
+    }
+    front.clear();
+    front_colors.clear();
+    front_requests.clear();
+    front_color_requests.clear();
+}
+
+/////////////////////////////////////////////////
+bool VisualScene::applyColors(const ColorState & _state)
+{
+    rendering::ScenePtr scene = rendering::get_scene();
+    if (!scene) { return false; }
+    rendering::VisualPtr visual = scene->GetVisual(_state.name);
+    if (!visual) {
+        gzwarn << "[VisualUtils] Visual not found: " << _state.name << std::endl;
+        return false;
+    }
+
+    if (_state.update_ambient) {
+        visual->SetAmbient(_state.ambient);
+    }
+    if (_state.update_diffuse) {
+        visual->SetDiffuse(_state.diffuse);
+    }
+    if (_state.update_specular) {
+        visual->SetSpecular(_state.specular);
+    }
+    if (_state.update_emissive) {
+        visual->SetEmissive(_state.emissive);
+    }
+    return true;
+}
+
+}
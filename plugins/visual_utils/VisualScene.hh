@@ -0,0 +1,199 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file visual_utils/VisualScene.hh
+    \brief Visual Scene class
+
+    Double-buffered scene state shared by every VisualUtils plugin instance,
+    so that each request is applied to all visuals in a single frame.
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _VISUAL_SCENE_HH_
+#define _VISUAL_SCENE_HH_
+
+// Gazebo
+#include <gazebo/common/Events.hh>
+#include <gazebo/msgs/msgs.hh>
+#include <gazebo/rendering/RenderingIface.hh>
+#include <gazebo/rendering/Scene.hh>
+#include <gazebo/rendering/Visual.hh>
+#include <gazebo/transport/Node.hh>
+
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// Custom messages
+#include "visual_utils_request.pb.h"
+#include "visual_utils_response.pb.h"
+
+namespace gazebo {
+
+    /// Shared pointer declaration for request message type
+    typedef const boost::shared_ptr<const gap::msgs::VisualUtilsRequest>
+        VisualUtilsRequestPtr;
+    /// Shared pointer declaration for response message type
+    typedef const boost::shared_ptr<const gap::msgs::VisualUtilsResponse>
+        VisualUtilsResponsePtr;
+
+    // Forward declaration of plugin class
+    class VisualUtils;
+
+    /// \brief Pending state of a single visual
+    class VisualState
+    {
+        /// Flag to update pose
+        public: bool update_pose {false};
+        /// Flag to update scale
+        public: bool update_scale {false};
+        /// Flag to update material
+        public: bool update_material {false};
+        /// New pose
+        public: ignition::math::Pose3d pose;
+        /// New scale
+        public: ignition::math::Vector3d scale;
+        /// New material
+        public: std::string material;
+
+        /// \brief Merges a newer state, whose flagged fields take precedence
+        /// \param _newer Newer visual state
+        public: void merge(const VisualState & _newer);
+    };
+
+    /// \brief Pending colors of a visual, targeted by scoped name
+    class ColorState
+    {
+        /// Visual scoped name
+        public: std::string name;
+        /// Flag to update ambient color
+        public: bool update_ambient {false};
+        /// Flag to update diffuse color
+        public: bool update_diffuse {false};
+        /// Flag to update specular color
+        public: bool update_specular {false};
+        /// Flag to update emissive color
+        public: bool update_emissive {false};
+        /// New ambient color
+        public: ignition::math::Color ambient;
+        /// New diffuse color
+        public: ignition::math::Color diffuse;
+        /// New specular color
+        public: ignition::math::Color specular;
+        /// New emissive color
+        public: ignition::math::Color emissive;
+    };
+
+    /// \brief Double-buffered state of every visual with a VisualUtils plugin
+    ///
+    /// Owns the single subscription to the VisualUtils request topic.
+    /// The transport thread writes the next state of every registered visual
+    /// to the back buffer. A single PreRender callback swaps buffers and
+    /// applies the whole state, so a rendered frame never shows a partially
+    /// updated scene. Requests received before the next frame are merged per
+    /// visual, the latest request winning for each field. One response is
+    /// still published per request, once the frame that applies it renders.
+    ///
+    /// COLOR requests may target any visual in the rendering scene by its
+    /// scoped name, e.g. model::link, not only those with a VisualUtils plugin.
+    ///
+    /// \warning Registration should only be performed in the rendering thread.
+    class VisualScene
+    {
+        /// Registered visual plugins
+        private: std::set<VisualUtils *> visuals;
+        /// State being applied in the rendering thread
+        private: std::map<VisualUtils *, VisualState> front;
+        /// State being written by the transport thread
+        private: std::map<VisualUtils *, VisualState> back;
+        /// Colors being applied in the rendering thread
+        private: std::vector<ColorState> front_colors;
+        /// Colors being written by the transport thread
+        private: std::vector<ColorState> back_colors;
+        /// Visuals targeted by each request being applied
+        private: std::vector<std::vector<VisualUtils *>> front_requests;
+        /// Visuals targeted by each request being written
+        private: std::vector<std::vector<VisualUtils *>> back_requests;
+        /// Number of colors in each color request being applied
+        private: std::vector<std::size_t> front_color_requests;
+        /// Number of colors in each color request being written
+        private: std::vector<std::size_t> back_color_requests;
+        /// Whether back buffer holds a pending update
+        private: bool pending {false};
+
+        /// Connects to rendering update event
+        private: event::ConnectionPtr updateConnection;
+        /// Gazebo transport node
+        private: transport::NodePtr node;
+        /// Visual utils topic subscriber
+        private: transport::SubscriberPtr sub;
+        /// A publisher to the reply topic
+        private: transport::PublisherPtr pub;
+
+        /// Mutex for safe access to back buffer and registry
+        private: std::mutex mutex;
+
+        /// \brief Obtains the shared instance
+        /// \return Process-wide visual scene
+        public: static VisualScene & instance();
+
+        /// \brief Registers a visual plugin
+        ///
+        /// Sets up transport and render callbacks on first registration.
+        ///
+        /// \param _plugin Plugin instance
+        public: void registerVisual(VisualUtils * _plugin);
+
+        /// \brief Unregisters a visual plugin
+        ///
+        /// Tears down transport and render callbacks on last removal.
+        ///
+        /// \param _plugin Plugin instance
+        public: void unregisterVisual(VisualUtils * _plugin);
+
+        /// \brief Constructs the object
+        private: VisualScene() = default;
+
+        /// \brief Callback function for handling incoming requests
+        /// \param _msg  The message
+        private: void onRequest(VisualUtilsRequestPtr & _msg);
+
+        /// \brief Handles incoming color request
+        /// \param _msg  The message
+        private: void onColorRequest(VisualUtilsRequestPtr & _msg);
+
+        /// \brief Replies with material catalog size of targeted visuals
+        ///
+        /// Every registered visual is reported if request has no targets.
+        /// \param _msg  The message
+        private: void onCatalogRequest(VisualUtilsRequestPtr & _msg);
+
+        /// \brief Swaps buffers and applies pending state to every visual
+        private: void onUpdate();
+
+        /// \brief Applies colors to a visual in the rendering scene
+        /// \param _state  The new visual colors
+        /// \return True on success, false if visual was not found
+        private: bool applyColors(const ColorState & _state);
+    };
+}
+
+#endif
@@ -34,43 +34,24 @@ class VisualUtilsPrivate
 {
     /// Visual to which the plugin is attached
     public: rendering::VisualPtr visual;
-    /// Connects to rendering update event
-    public: event::ConnectionPtr updateConnection;
-    /// Gazebo transport node
-    public: transport::NodePtr node;
-    /// Visual utils topic subscriber
-    public: transport::SubscriberPtr sub;
-    /// A publisher to the reply topic
-    public: transport::PublisherPtr pub;
+    /// Whether plugin is registered in shared visual scene
+    public: bool registered {false};
 
     /// Unique name
     public: std::string name;
     /// Material name patterns
     public: std::vector<std::string> patterns;
-    /// Available materials
+    /// Available materials, sorted by name
     public: std::vector<std::string> materials;
+    /// Shuffled indices of available materials
+    public: std::vector<unsigned int> random_order;
     /// Internal counter for used materials
     public: unsigned int used_materials {0};
+    /// Material currently applied to the visual
+    public: std::string current_material;
 
     /// Default pose
     public: ignition::math::Pose3d default_pose;
-
-    /// Mutex
-    public: std::mutex mutex;
-
-    /// Flag to update pose
-    public: bool update_pose {false};
-    /// Flag to update material
-    public: bool update_material {false};
-    /// Flag to update scale
-    public: bool update_scale {false};
-
-    /// New pose
-    public: ignition::math::Pose3d new_pose;
-    /// New material
-    public: std::string new_material;
-    /// New scale
-    public: ignition::math::Vector3d new_scale;
 };
 
 /// Register this plugin with the simulator
@@ -84,8 +65,12 @@ VisualUtils::VisualUtils(): VisualPlugin(), dataPtr(new VisualUtilsPrivate)
 /////////////////////////////////////////////////
 VisualUtils::~VisualUtils()
 {
-    dataPtr->sub.reset();
-    dataPtr->node->Fini();
+    if (dataPtr->registered) {
+        VisualScene::instance().unregisterVisual(this);
+    }
+    if (!dataPtr->current_material.empty()) {
+        MaterialCache::instance().release(dataPtr->current_material);
+    }
     gzmsg << "[VisualUtils] Unloaded visual tools: " << dataPtr->name << std::endl;
 }
 
@@ -114,8 +99,9 @@ void VisualUtils::Load(rendering::VisualPtr _visual, sdf::ElementPtr _sdf)
         boost::split(dataPtr->patterns, patterns_arg,
             boost::is_any_of(" "), boost::token_compress_on);
     } else {
-        gzerr << "[VisualUtils] No material name patterns provided.";
-        return;
+        gzmsg << "[VisualUtils] No material name patterns provided, "
+            << "materials of " << dataPtr->name << " are left unchanged."
+            << std::endl;
     }
 
     // Visual settings
@@ -123,110 +109,96 @@ void VisualUtils::Load(rendering::VisualPtr _visual, sdf::ElementPtr _sdf)
     dataPtr->visual->SetCastShadows(true);
     dataPtr->visual->SetLighting(true);
 
-    // Connect to the world update signal
-    dataPtr->updateConnection = event::Events::ConnectPreRender(
-        std::bind(&VisualUtils::Update, this));
-     // Setup transport node
-    dataPtr->node = transport::NodePtr(new transport::Node());
-    dataPtr->node->Init();
-    // Subcribe to the monitored requests topic
-    dataPtr->sub = dataPtr->node->Subscribe(REQUEST_TOPIC,
-        &VisualUtils::onRequest, this);
-    // Setup publisher for the response topic
-    dataPtr->pub = dataPtr->node->
-        Advertise<gap::msgs::VisualUtilsResponse>(RESPONSE_TOPIC);
-
     // Default pose
     dataPtr->default_pose = _visual->Pose();
     // Load materials
     loadResources();
 
+    // Material cache settings
+    if (_sdf->HasElement("max_loaded")) {
+        MaterialCache::instance().setCapacity(
+            _sdf->Get<unsigned int>("max_loaded"));
+    }
+    if (_sdf->HasElement("preload") && _sdf->Get<bool>("preload")) {
+        MaterialCache::instance().preload(dataPtr->materials);
+    }
+
+    // Handle requests in shared scene, once plugin is fully loaded
+    VisualScene::instance().registerVisual(this);
+    dataPtr->registered = true;
+
     gzmsg << "[VisualUtils] Loaded visual tools: " << dataPtr->name << std::endl;
 }
 
 /////////////////////////////////////////////////
-void VisualUtils::Update()
+const std::string & VisualUtils::uid() const
 {
-    std::lock_guard<std::mutex> lock(dataPtr->mutex);
+    return dataPtr->name;
+}
 
-    gap::msgs::VisualUtilsResponse msg;
-    bool updated = false;
+/////////////////////////////////////////////////
+unsigned int VisualUtils::catalogSize() const
+{
+    return dataPtr->materials.size();
+}
 
+/////////////////////////////////////////////////
+void VisualUtils::apply(const VisualState & _state)
+{
     // Update scale
-    if (dataPtr->update_scale) {
-        if (dataPtr->visual->Scale() != dataPtr->new_scale) {
-            dataPtr->visual->SetScale(dataPtr->new_scale);
+    if (_state.update_scale) {
+        if (dataPtr->visual->Scale() != _state.scale) {
+            dataPtr->visual->SetScale(_state.scale);
         }
-        dataPtr->update_scale = false;
-        updated = true;
     }
     // Update pose
-    if (dataPtr->update_pose) {
-        if (dataPtr->visual->WorldPose() != dataPtr->new_pose) {
-            dataPtr->visual->SetWorldPose(dataPtr->new_pose);
+    if (_state.update_pose) {
+        if (dataPtr->visual->WorldPose() != _state.pose) {
+            dataPtr->visual->SetWorldPose(_state.pose);
         }
-        dataPtr->update_pose = false;
-        updated = true;
     }
     // Update material
-    if (dataPtr->update_material) {
-        dataPtr->visual->SetMaterial(dataPtr->new_material,false,false);
-        dataPtr->update_material = false;
-        updated = true;
-    }
-
-    // Notify subscribers to the response topic that visual was updated
-    if (updated) {
-        msg.set_type(UPDATED);
-        msg.set_origin(dataPtr->name);
-        dataPtr->pub->Publish(msg);
+    if (_state.update_material) {
+        // Ensure material is resident before applying it
+        MaterialCache::instance().acquire(_state.material);
+        if (!dataPtr->current_material.empty()) {
+            MaterialCache::instance().release(dataPtr->current_material);
+        }
+        dataPtr->current_material = _state.material;
+        dataPtr->visual->SetMaterial(_state.material,false,false);
     }
 }
 
 /////////////////////////////////////////////////
-void VisualUtils::onRequest(VisualUtilsRequestPtr &_msg)
+bool VisualUtils::onRequest(
+    VisualUtilsRequestPtr &_msg,
+    int index,
+    VisualState &state)
 {
-    // Relevant index of commands in message for the current visual
-    int index = -1;
-
-    // Validate msg structure
-    if (!_msg->has_type()) {
-        gzwarn <<" [VisualUtils] Invalid request received" << std::endl;
-        return;
-    }
-
-    // Check if current visual is targeted
-    for (int i = 0; i < _msg->targets_size(); i++) {
-        if (dataPtr->name == _msg->targets(i)) {
-            index = i; break;
-        }
-    }
-
     if (_msg->type() == UPDATE)
     {
-        std::lock_guard<std::mutex> lock(dataPtr->mutex);
-
         if (index == -1) {
             // Ĩf visual is not targeted, set new pose to default pose
-            dataPtr->new_pose = dataPtr->default_pose;
-            dataPtr->update_pose = true;
+            state.pose = dataPtr->default_pose;
+            state.update_pose = true;
         } else {
             if (index < _msg->poses_size()) {
-                dataPtr->new_pose = gazebo::msgs::ConvertIgn(_msg->poses(index));
-                dataPtr->update_pose = true;
+                state.pose = gazebo::msgs::ConvertIgn(_msg->poses(index));
+                state.update_pose = true;
             }
             if (index < _msg->scale_size()) {
-                dataPtr->new_scale = gazebo::msgs::ConvertIgn(_msg->scale(index));
-                dataPtr->update_scale = true;
+                state.scale = gazebo::msgs::ConvertIgn(_msg->scale(index));
+                state.update_scale = true;
+            }
+            if (!requestedMaterialName(_msg, index, state.material)) {
+                randomMaterialName(state.material);
             }
-            randomMaterialName(dataPtr->new_material);
-            dataPtr->update_material = true;
+            state.update_material = !state.material.empty();
         }
+        return true;
     }
     else if (_msg->type() == DEFAULT_POSE)
     {
-        std::lock_guard<std::mutex> lock(dataPtr->mutex);
-
         if (index != -1) {
             if (index < _msg->poses_size()) {
                 dataPtr->default_pose = gazebo::msgs::ConvertIgn(
@@ -234,40 +206,24 @@ void VisualUtils::onRequest(VisualUtilsRequestPtr &_msg)
             }
         }
     }
+    return false;
 }
 
 /////////////////////////////////////////////////
 void VisualUtils::loadResources()
 {
-    std::lock_guard<std::mutex> lock(dataPtr->mutex);
-
-    // Clear materials
-    dataPtr->materials.clear();
-    // Get list of OGRE resources
-    Ogre::ResourceManager::ResourceMapIterator resources = 
-        Ogre::MaterialManager::getSingleton().getResourceIterator();
-    // Add materials that match material patterns
-    std::string name;
-    for (auto & material : resources)
-    {
-        name = material.second->getName();
-        for (auto & pattern : dataPtr->patterns)
-        {
-            // Check if pattern matches prefix
-            auto res = std::mismatch(
-                pattern.begin(), pattern.end(), name.begin());
-            if (res.first == pattern.end()) {
-                dataPtr->materials.push_back(name);
-            }
-        }
-    }
+    // Sorted materials that match patterns, so catalog indices are reproducible
+    dataPtr->materials = MaterialCache::catalog(dataPtr->patterns);
 
-    // Shuffle materials vector
+    // Shuffle material indices, for random round-robin selection
+    dataPtr->random_order.resize(dataPtr->materials.size());
+    std::iota(dataPtr->random_order.begin(), dataPtr->random_order.end(), 0);
     unsigned int seed =
         std::chrono::system_clock::now().time_since_epoch().count();
     auto rng = std::mt19937 {seed};
-    std::shuffle(std::begin(dataPtr->materials),
-        std::end(dataPtr->materials), rng);
+    std::shuffle(std::begin(dataPtr->random_order),
+        std::end(dataPtr->random_order), rng);
+    dataPtr->used_materials = 0;
 
     /*
     gzdbg << dataPtr->materials.size()
@@ -278,20 +234,54 @@ void VisualUtils::loadResources()
 /////////////////////////////////////////////////
 void VisualUtils::randomMaterialName(std::string &name)
 {
-    if (dataPtr->used_materials == dataPtr->materials.size())
+    if (dataPtr->random_order.empty()) {
+        name.clear();
+        return;
+    }
+    if (dataPtr->used_materials == dataPtr->random_order.size())
     {
         // All materials have been used once. Reshuffle    
         unsigned int seed =
             std::chrono::system_clock::now().time_since_epoch().count();
         auto rng = std::mt19937 {seed};
-        std::shuffle(std::begin(dataPtr->materials),
-            std::end(dataPtr->materials), rng);
+        std::shuffle(std::begin(dataPtr->random_order),
+            std::end(dataPtr->random_order), rng);
         dataPtr->used_materials = 0;
     }
-    else
+    name = dataPtr->materials.at(
+        dataPtr->random_order.at(dataPtr->used_materials++));
+}
+
+/////////////////////////////////////////////////
+bool VisualUtils::requestedMaterialName(
+    VisualUtilsRequestPtr &_msg,
+    int index,
+    std::string &name)
+{
+    // Explicit material name takes precedence over catalog index
+    if (index < _msg->materials_size() && !_msg->materials(index).empty())
     {
-        name = dataPtr->materials.at(dataPtr->used_materials++);
+        const std::string & material = _msg->materials(index);
+        if (!Ogre::MaterialManager::getSingleton().resourceExists(material)) {
+            gzwarn << "[VisualUtils] Unknown material " << material
+                << " requested for " << dataPtr->name << std::endl;
+            return false;
+        }
+        name = material;
+        return true;
     }
-} 
+    if (index < _msg->material_ids_size() && _msg->material_ids(index) >= 0)
+    {
+        unsigned int id = _msg->material_ids(index);
+        if (id >= dataPtr->materials.size()) {
+            gzwarn << "[VisualUtils] Material index " << id
+                << " out of range for " << dataPtr->name << std::endl;
+            return false;
+        }
+        name = dataPtr->materials.at(id);
+        return true;
+    }
+    return false;
+}
 
 }
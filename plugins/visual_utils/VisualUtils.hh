@@ -41,6 +41,7 @@
 #include <mutex>
 // Shuffle vector
 #include <algorithm>
+#include <numeric>
 #include <random>
 #include <chrono>
 
@@ -48,6 +49,11 @@
 #include "visual_utils_request.pb.h"
 #include "visual_utils_response.pb.h"
 
+// Shared cache of loaded materials
+#include "MaterialCache.hh"
+// Shared double-buffered scene state
+#include "VisualScene.hh"
+
 namespace VisualUtils {
 
 /// Topic monitored for incoming commands
@@ -59,11 +65,17 @@ namespace VisualUtils {
 #define UPDATE          gap::msgs::VisualUtilsRequest::UPDATE
 /// Set default pose
 #define DEFAULT_POSE    gap::msgs::VisualUtilsRequest::DEFAULT_POSE
+/// Set visual colors
+#define COLOR           gap::msgs::VisualUtilsRequest::COLOR
+/// Get material catalog sizes
+#define CATALOG         gap::msgs::VisualUtilsRequest::CATALOG
 /// TODO
 #define MATERIAL        gap::msgs::VisualUtilsRequest::MATERIAL_PREFIX
 
 /// Visual updated response
 #define UPDATED         gap::msgs::VisualUtilsResponse::UPDATED
+/// Material catalog sizes response
+#define CATALOG_SIZES   gap::msgs::VisualUtilsResponse::CATALOG
 
 // Default parameters
 
@@ -74,13 +86,6 @@ namespace VisualUtils {
 
 namespace gazebo{
 
-    /// Shared pointer declaration for request message type
-    typedef const boost::shared_ptr<const gap::msgs::VisualUtilsRequest>
-        VisualUtilsRequestPtr;
-    /// Shared pointer declaration for response message type
-    typedef const boost::shared_ptr<const gap::msgs::VisualUtilsResponse>
-        VisualUtilsResponsePtr;
-
     // Forward declaration of private data class
     class VisualUtilsPrivate;
 
@@ -88,19 +93,37 @@ namespace gazebo{
     /// alter visuals during simulation.
     ///
     /// Materials are assumed to be loaded and name [pattern][index]
+    /// Update requests may select a material explicitly, either by name or
+    /// by its index in the alphabetically sorted catalog of materials
+    /// matching the given patterns. Otherwise, one is picked at random.
+    /// CATALOG requests report the catalog size of each visual, so that
+    /// clients may pick indices reproducibly themselves.
+    ///
+    /// Requests are handled by a VisualScene shared by every instance, which
+    /// applies the whole update in a single rendered frame and replies to each
+    /// request with one response listing its visuals and applied materials.
+    ///
     /// See the example usage below:
     ///
     /// \code{.xml}
     ///    <plugin name="visual_utils" filename="libVisualUtils.so">
     ///     <!-- Unique name identifier -->
     ///     <uid>box_1</uid>
-    ///     <!-- Prefix patterns for material names, separated by whitespace -->
+    ///     <!-- Optional: prefix patterns of material names, whitespace separated -->
     ///     <patterns>Plugin/flat_ Plugin/gradient_ ... </patterns>
     ///     <!-- Number of variants per prefix pattern -->
     ///     <variants>100</variants>
+    ///     <!-- Optional: load matching materials ahead of time -->
+    ///     <preload>true</preload>
+    ///     <!-- Optional: max loaded materials, shared by every instance -->
+    ///     <max_loaded>500</max_loaded>
     ///    </plugin>
     /// \endcode
     ///
+    /// Preloading avoids texture uploads to the GPU on the first use of each
+    /// material, which would otherwise stall the render thread.
+    /// With max_loaded set, least recently used materials are unloaded.
+    ///
     /// See worlds/visual.world for a complete example.
     class VisualUtils : public VisualPlugin {
 
@@ -117,12 +140,35 @@ namespace gazebo{
             rendering::VisualPtr _visual,
             sdf::ElementPtr _sdf);
 
-        /// \brief Update once per simulation iteration.
-        public: void Update();
-
-        /// \brief Callback function for handling incoming requests
-        /// \param _msg  The message
-        public: void onRequest(VisualUtilsRequestPtr & _msg);
+        /// \brief Obtains the unique name of the plugin
+        /// \return Unique name
+        public: const std::string & uid() const;
+
+        /// \brief Obtains the number of materials matching the patterns
+        ///
+        /// Catalog indices in update requests range from zero to this value
+        /// \return Size of material catalog
+        public: unsigned int catalogSize() const;
+
+        /// \brief Applies new state to the visual
+        ///
+        /// Called from the rendering thread.
+        ///
+        /// \param _state  The new visual state
+        public: void apply(const VisualState & _state);
+
+        /// \brief Handles incoming request
+        ///
+        /// Called from the transport thread, by the shared visual scene.
+        ///
+        /// \param _msg    The message
+        /// \param index   Index of the visual in the request targets, or -1
+        /// \param state   Output new visual state
+        /// \return True if the visual should be updated, false otherwise
+        public: bool onRequest(
+            VisualUtilsRequestPtr & _msg,
+            int index,
+            VisualState & state);
 
         /// \brief Private data pointer
         private: std::unique_ptr<VisualUtilsPrivate> dataPtr;
@@ -133,5 +179,15 @@ namespace gazebo{
         /// \brief Randomly generates a new material name.
         /// \param name Output random material name
         private: void randomMaterialName(std::string & name);
+
+        /// \brief Obtains material name explicitly requested for the visual
+        /// \param _msg    The request message
+        /// \param index   Index of the visual in the request targets
+        /// \param name    Output material name
+        /// \return True if a valid material was requested, false otherwise
+        private: bool requestedMaterialName(
+            VisualUtilsRequestPtr & _msg,
+            int index,
+            std::string & name);
     };
 }
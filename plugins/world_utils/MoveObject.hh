@@ -28,6 +28,7 @@
 #include "gazebo/common/Plugin.hh"
 
 #include <string>
+#include <vector>
 
 /// \brief Object with a pending move operation
 class MoveObject
@@ -38,6 +39,8 @@ class MoveObject
     public: bool is_light;
     /// \brief Object new pose
     public: ignition::math::Pose3d pose;
+    /// \brief Whether pose is set, otherwise object keeps its previous pose
+    public: bool has_pose {true};
 
     /// \brief Constructs the object
     /// \param _name        Object name
@@ -48,3 +51,14 @@ class MoveObject
         bool _is_light,
         ignition::math::Pose3d & _pose);
 };
+
+/// \brief Request with objects to be moved in the same update
+class MoveRequest
+{
+    /// \brief Whether request has an identifier
+    public: bool has_id {false};
+    /// \brief Request identifier
+    public: unsigned int id {0};
+    /// \brief Objects to move
+    public: std::vector<MoveObject> objects;
+};
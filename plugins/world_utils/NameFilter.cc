@@ -0,0 +1,68 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file world_utils/NameFilter.cc
+    \brief Name Filter class implementation
+
+    Class for matching entity names against a set of patterns
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "NameFilter.hh"
+
+/// Matching criteria
+typedef gap::msgs::WorldUtilsRequest Request;
+
+NameFilter::NameFilter(
+    const std::vector<std::string> & _patterns,
+    const int _match) :
+        match(_match), patterns(_patterns)
+{
+    if (match == Request::REGEX) {
+        for (const auto & pattern : patterns) {
+            regexes.emplace_back(pattern);
+        }
+    } else if (match == Request::EXACT) {
+        exact.insert(patterns.begin(), patterns.end());
+    }
+}
+
+/////////////////////////////////////////////////
+bool NameFilter::operator()(const std::string & _name) const
+{
+    if (patterns.empty()) {
+        return true;
+    }
+    if (match == Request::EXACT) {
+        return exact.count(_name);
+    }
+
+    for (std::size_t i = 0; i < patterns.size(); i++)
+    {
+        const std::string & pattern = patterns[i];
+        if (match == Request::PREFIX) {
+            if (!_name.compare(0, pattern.size(), pattern)) return true;
+        } else if (match == Request::REGEX) {
+            if (std::regex_match(_name, regexes[i])) return true;
+        } else if (_name.find(pattern) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,68 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file world_utils/NameFilter.hh
+    \brief Name Filter class
+
+    Class for matching entity names against a set of patterns
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _NAME_FILTER_HH_
+#define _NAME_FILTER_HH_
+
+// Custom messages
+#include "world_utils_request.pb.h"
+
+#include <regex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/// \brief Matches entity names against a set of patterns
+///
+/// Patterns are prepared once, so that many names can be checked cheaply.
+/// An empty set of patterns matches every name.
+class NameFilter
+{
+    /// \brief Matching criteria, as in WorldUtilsRequest::Match
+    private: int match;
+    /// \brief Patterns to be matched
+    private: std::vector<std::string> patterns;
+    /// \brief Compiled regular expressions, for REGEX criteria
+    private: std::vector<std::regex> regexes;
+    /// \brief Pattern set, for EXACT criteria
+    private: std::unordered_set<std::string> exact;
+
+    /// \brief Constructs the object
+    ///
+    /// Throws std::regex_error on invalid regular expressions
+    /// \param _patterns    Patterns to be matched
+    /// \param _match       Matching criteria
+    public: NameFilter(
+        const std::vector<std::string> & _patterns,
+        const int _match=gap::msgs::WorldUtilsRequest::CONTAINS);
+
+    /// \brief Checks whether name matches any pattern
+    /// \param _name    Entity name
+    /// \return True on match
+    public: bool operator()(const std::string & _name) const;
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file world_utils/PendingRequest.cc
+    \brief Pending Request class implementation
+
+    Class for a spawn or removal request awaiting completion
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "PendingRequest.hh"
+
+PendingRequest::PendingRequest(double _timeout) :
+    deadline(gazebo::common::Time::GetWallTime() + _timeout)
+{
+}
+
+/////////////////////////////////////////////////
+void PendingRequest::add(
+    const std::string & _name,
+    bool _is_light,
+    bool _failed)
+{
+    names.push_back(_name);
+    is_light.push_back(_is_light);
+    done.push_back(_failed);
+    success.push_back(false);
+}
+
+/////////////////////////////////////////////////
+void PendingRequest::resolve(std::size_t _idx, bool _success)
+{
+    done[_idx] = true;
+    success[_idx] = _success;
+}
+
+/////////////////////////////////////////////////
+bool PendingRequest::complete() const
+{
+    for (bool d : done) {
+        if (!d) return false;
+    }
+    return true;
+}
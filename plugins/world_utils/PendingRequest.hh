@@ -0,0 +1,91 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file world_utils/PendingRequest.hh
+    \brief Pending Request class
+
+    Class for a spawn or removal request awaiting completion
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _PENDING_REQUEST_HH_
+#define _PENDING_REQUEST_HH_
+
+// Gazebo
+#include <gazebo/common/Time.hh>
+
+#include <string>
+#include <vector>
+
+/// \brief Spawn or removal request awaiting completion
+///
+/// Holds the entities requested in a single spawn or removal request, and
+/// whether each of them is already present in or gone from the world
+class PendingRequest
+{
+    /// \brief Whether entities are to be removed rather than spawned
+    public: bool removal {false};
+    /// \brief Whether request has an identifier
+    public: bool has_id {false};
+    /// \brief Request identifier
+    public: unsigned int id {0};
+    /// \brief Entity names
+    public: std::vector<std::string> names;
+    /// \brief Whether each entity is a light
+    public: std::vector<bool> is_light;
+    /// \brief Whether each entity is resolved, either processed or failed
+    public: std::vector<bool> done;
+    /// \brief Whether each entity was processed successfully
+    public: std::vector<bool> success;
+    /// \brief Wall time after which unresolved entities fail
+    public: gazebo::common::Time deadline;
+
+    /// \brief Constructs the object
+    /// \param _timeout Maximum time to wait for entities, in seconds
+    public: PendingRequest(double _timeout);
+
+    /// \brief Adds entity to request
+    /// \param _name     Entity name
+    /// \param _is_light Whether the entity is a light
+    /// \param _failed   Whether the request is known to have failed
+    public: void add(
+        const std::string & _name,
+        bool _is_light,
+        bool _failed=false);
+
+    /// \brief Marks entity as resolved
+    /// \param _idx      Entity index
+    /// \param _success  Whether the entity was processed
+    public: void resolve(std::size_t _idx, bool _success);
+
+    /// \brief Checks whether every entity is resolved
+    /// \return True if request is complete
+    public: bool complete() const;
+};
+
+/// \brief Model whose insertion awaits removal of an entity with its name
+class DeferredModel
+{
+    /// \brief SDF string of the model
+    public: std::string sdf;
+    /// \brief Wall time after which the model is dropped
+    public: gazebo::common::Time deadline;
+};
+
+#endif
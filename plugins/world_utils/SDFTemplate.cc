@@ -0,0 +1,117 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file world_utils/SDFTemplate.cc
+    \brief SDF Template class implementation
+
+    Class for a pre-processed SDF string with replaceable name, pose,
+    material and scale
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "SDFTemplate.hh"
+
+/// Counter for unique template identifiers
+static std::atomic<unsigned int> g_template_counter {0};
+
+/////////////////////////////////////////////////
+SDFTemplate::SDFTemplate(const std::string & _sdf) :
+    length(_sdf.size()), id(g_template_counter++)
+{
+    // Capture groups of each slot type, in order of declaration
+    static const std::regex slot_reg(
+        "(" REGEX_XML_POSE ")|(" REGEX_XML_SCRIPT ")|(" REGEX_XML_SCALE ")|"
+        "(" REGEX_XML_UID ")|" REGEX_XML_NAME);
+
+    std::size_t last = 0;
+    bool has_name = false;
+
+    auto begin = std::sregex_iterator(_sdf.begin(), _sdf.end(), slot_reg);
+    for (auto it = begin; it != std::sregex_iterator(); ++it)
+    {
+        const std::smatch & match = *it;
+
+        // Only the quoted name of the outermost entity is replaceable
+        int group = 0;
+        Slot slot;
+        if (match[1].matched)       { group = 1; slot = POSE;   }
+        else if (match[2].matched)  { group = 2; slot = SCRIPT; }
+        else if (match[3].matched)  { group = 3; slot = SCALE;  }
+        else if (match[4].matched)  { group = 4; slot = UID;    }
+        else if (!has_name)         { group = 6; slot = NAME;   }
+        else continue;
+
+        has_name = has_name || (slot == NAME);
+        std::size_t pos = match.position(group);
+        segments.push_back(_sdf.substr(last, pos - last));
+        slots.push_back(slot);
+        originals.push_back(match.str(group));
+        last = pos + match.length(group);
+    }
+    segments.push_back(_sdf.substr(last));
+}
+
+/////////////////////////////////////////////////
+std::string SDFTemplate::name() const
+{
+    for (std::size_t i = 0; i < slots.size(); i++)
+    {
+        if (slots[i] == NAME) {
+            // Strip quotes
+            return originals[i].substr(1, originals[i].size() - 2);
+        }
+    }
+    return std::string();
+}
+
+/////////////////////////////////////////////////
+std::string SDFTemplate::instantiate(const SDFOverrides & _overrides) const
+{
+    std::string out;
+    out.reserve(length + 256);
+
+    for (std::size_t i = 0; i < slots.size(); i++)
+    {
+        out += segments[i];
+        const Slot slot = slots[i];
+        const std::string & name = _overrides.name;
+
+        if (slot == NAME && !name.empty()) {
+            out += "\"" + name + "\"";
+        } else if (slot == UID && !name.empty()) {
+            out += "<uid>" + name + "</uid>";
+        } else if (slot == POSE && !_overrides.pose.empty()) {
+            out += _overrides.pose;
+        } else if (slot == SCRIPT && !_overrides.script.empty()) {
+            out += _overrides.script;
+        } else if (slot == SCALE && !_overrides.scale.empty()) {
+            out += _overrides.scale;
+        } else {
+            out += originals[i];
+        }
+    }
+    out += segments.back();
+    return out;
+}
+
+/////////////////////////////////////////////////
+bool SDFTemplate::matches(const std::string & _sdf) const
+{
+    // Without replacements, instantiation yields the original string
+    return _sdf.size() == length && instantiate(SDFOverrides()) == _sdf;
+}
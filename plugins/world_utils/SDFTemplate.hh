@@ -0,0 +1,112 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file world_utils/SDFTemplate.hh
+    \brief SDF Template class
+
+    Class for a pre-processed SDF string with replaceable name, pose,
+    material and scale
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _SDF_TEMPLATE_HH_
+#define _SDF_TEMPLATE_HH_
+
+#include <atomic>
+#include <regex>
+#include <string>
+#include <vector>
+
+// Regex patterns
+
+// Do not raise documentation warning
+//! @cond DoNotRaiseWarning
+
+/// Matches string enclosed in <script> XML tags
+#define REGEX_XML_SCRIPT "<script>[\\s\\S]*?<\\/script>"
+/// Matches string enclosed in <pose> XML tags
+#define REGEX_XML_POSE   "<pose>[\\s\\S]*?<\\/pose>"
+/// Matches string enclosed in <scale> XML tags
+#define REGEX_XML_SCALE  "<scale>[\\s\\S]*?<\\/scale>"
+/// Matches string enclosed in <uid> XML tags
+#define REGEX_XML_UID    "<uid>[\\s\\S]*?<\\/uid>"
+/// Matches model or light opening tag (1) and its quoted name (2)
+#define REGEX_XML_NAME   "(<(?:model|light)\\s[^>]*?\\bname\\s*=\\s*)(\"[^\"]*\"|'[^']*')"
+
+//! @endcond
+
+/// \brief Replacements for an SDF template instance
+///
+/// Empty fields keep the original content of the template
+class SDFOverrides
+{
+    /// \brief Model or light name, also used as VisualUtils <uid>
+    public: std::string name;
+    /// \brief Replacement <pose> XML
+    public: std::string pose;
+    /// \brief Replacement material <script> XML
+    public: std::string script;
+    /// \brief Replacement mesh <scale> XML
+    public: std::string scale;
+};
+
+/// \brief Pre-processed SDF string with replaceable name, pose, material
+/// and scale
+///
+/// The SDF string is scanned once for <pose>, <script>, <scale> and <uid>
+/// tags, as well as the name of the top-level model or light, and split
+/// into constant segments and replaceable slots.
+/// Each instance is then obtained by concatenation, instead of running
+/// regular expressions over the whole string on every spawn.
+class SDFTemplate
+{
+    /// \brief Type of replaceable slot
+    private: enum Slot { NAME, UID, POSE, SCRIPT, SCALE };
+
+    /// Constant segments, one more than the number of slots
+    private: std::vector<std::string> segments;
+    /// Type of each slot
+    private: std::vector<Slot> slots;
+    /// Original content of each slot
+    private: std::vector<std::string> originals;
+    /// Total length of original string
+    private: std::size_t length {0};
+
+    /// Unique template identifier, differs even for templates with same content
+    public: const unsigned int id;
+
+    /// \brief Constructs the object
+    /// \param _sdf SDF string
+    public: SDFTemplate(const std::string & _sdf);
+
+    /// \brief Obtains the original name of the model or light
+    /// \return Entity name, empty if not found
+    public: std::string name() const;
+
+    /// \brief Creates SDF string with replaced content
+    /// \param _overrides  Replacement content
+    /// \return SDF string
+    public: std::string instantiate(const SDFOverrides & _overrides) const;
+
+    /// \brief Checks whether template was built from a given SDF string
+    /// \param _sdf SDF string
+    /// \return True if content is the same
+    public: bool matches(const std::string & _sdf) const;
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file world_utils/WorkerPool.cc
+    \brief Worker Pool class implementation
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "WorkerPool.hh"
+
+#include <algorithm>
+#include <atomic>
+
+/////////////////////////////////////////////////
+WorkerPool::WorkerPool(const unsigned int _threads)
+{
+    for (unsigned int i = 0; i < _threads; i++) {
+        this->threads.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+/////////////////////////////////////////////////
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stop = true;
+    }
+    this->task_cond.notify_all();
+    for (auto & thread : this->threads) {
+        thread.join();
+    }
+}
+
+/////////////////////////////////////////////////
+void WorkerPool::parallelFor(
+    const std::size_t _n,
+    const std::function<void (std::size_t)> & _task)
+{
+    const std::size_t helpers = std::min(this->threads.size(), _n - (_n > 0));
+    if (helpers == 0) {
+        for (std::size_t i = 0; i < _n; i++) {
+            _task(i);
+        }
+        return;
+    }
+
+    // Workers pick the next index until every task is done
+    std::atomic<std::size_t> next {0};
+    auto work = [&]() {
+        for (std::size_t i = next++; i < _n; i = next++) {
+            _task(i);
+        }
+    };
+
+    // Helpers still running this loop, guarded by mutex
+    std::size_t running = helpers;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (std::size_t t = 0; t < helpers; t++)
+        {
+            this->tasks.emplace([&]() {
+                work();
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (--running == 0) {
+                    this->done_cond.notify_all();
+                }
+            });
+        }
+    }
+    this->task_cond.notify_all();
+
+    work();
+
+    // Loop state lives on this stack frame, so wait for every helper
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->done_cond.wait(lock, [&]() { return running == 0; });
+}
+
+/////////////////////////////////////////////////
+void WorkerPool::run()
+{
+    while (true)
+    {
+        std::function<void ()> task;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->task_cond.wait(lock, [this]() {
+                return this->stop || !this->tasks.empty(); });
+            if (this->tasks.empty()) {
+                return;
+            }
+            task = std::move(this->tasks.front());
+            this->tasks.pop();
+        }
+        task();
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file world_utils/WorkerPool.hh
+    \brief Worker Pool class
+
+    Class for running batches of tasks on persistent worker threads
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _WORKER_POOL_HH_
+#define _WORKER_POOL_HH_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/// \brief Persistent worker threads for parallel loops
+///
+/// Threads are started once and wait for work on a task queue, so that
+/// small batches do not pay for thread creation.
+/// The calling thread takes part in each loop, hence a pool with n threads
+/// runs loops on up to n + 1 threads.
+class WorkerPool
+{
+    /// \brief Worker threads
+    private: std::vector<std::thread> threads;
+    /// \brief Queued tasks
+    private: std::queue<std::function<void ()>> tasks;
+    /// \brief Mutex for task queue and loop completion
+    private: std::mutex mutex;
+    /// \brief Signalled when tasks are queued or the pool stops
+    private: std::condition_variable task_cond;
+    /// \brief Signalled when a worker leaves a loop
+    private: std::condition_variable done_cond;
+    /// \brief Whether workers should exit
+    private: bool stop {false};
+
+    /// \brief Constructs the object and starts worker threads
+    /// \param _threads Number of worker threads
+    public: WorkerPool(const unsigned int _threads);
+
+    /// \brief Stops and joins worker threads
+    public: ~WorkerPool();
+
+    /// \brief Runs tasks in parallel, returning once every task is done
+    /// \param _n       Number of tasks
+    /// \param _task    Task function, receives task index
+    public: void parallelFor(
+        const std::size_t _n,
+        const std::function<void (std::size_t)> & _task);
+
+    /// \brief Worker thread loop, runs queued tasks until pool stops
+    private: void run();
+};
+
+#endif
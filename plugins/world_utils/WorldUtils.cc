@@ -40,15 +40,37 @@ void WorldUtils::Load(physics::WorldPtr _world, sdf::ElementPtr _sdf){
 
     // Plugin parameters
     this->world = _world;
+    if (_sdf->HasElement("pool")) {
+        this->pool = _sdf->Get<bool>("pool");
+    }
+    if (_sdf->HasElement("workers")) {
+        this->workers = std::max(1u, _sdf->Get<unsigned int>("workers"));
+    }
+    // Requesting thread works as well
+    this->worker_pool.reset(new WorkerPool(this->workers - 1));
+    if (_sdf->HasElement("validate")) {
+        this->validate = _sdf->Get<bool>("validate");
+    }
+    if (this->validate) {
+        // Empty SDF description, copied for each validated object
+        sdf::SDFPtr description(new sdf::SDF());
+        sdf::init(description);
+        this->description = description->Root();
+    }
+    if (_sdf->HasElement("timeout")) {
+        this->timeout = _sdf->Get<double>("timeout");
+    }
+    if (_sdf->HasElement("park_pose")) {
+        this->park_pose = _sdf->Get<ignition::math::Pose3d>("park_pose");
+    }
 
     // Subscriber setup
     this->node = transport::NodePtr(new transport::Node());
     this->node->Init(this->world->Name());
 
     // Setup publisher for the gazebo request topic
-    this->request_pub = this->node->Advertise<msgs::Request>("~/request");
-    // Setup publisher for the modify light request topic
-    this->light_pub = this->node->Advertise<msgs::Light>("~/light/modify");
+    this->request_pub = this->node->
+        Advertise<msgs::Request>("~/request", REQUEST_QUEUE_LIMIT);
 
     // Subcribe to the request topic
     this->sub = this->node->Subscribe(REQUEST_TOPIC, &WorldUtils::onRequest, this);
@@ -56,10 +78,19 @@ void WorldUtils::Load(physics::WorldPtr _world, sdf::ElementPtr _sdf){
     this->pub = this->node->
         Advertise<gap::msgs::WorldUtilsResponse>(RESPONSE_TOPIC);
 
-    // Setup regular expression used for texture replacement
-    this->script_reg = std::regex(REGEX_XML_SCRIPT);
-    // Setup regular expression used for pose replacement
-    this->pose_reg = std::regex(REGEX_XML_POSE);
+
+    // Track models already in the world, and those added or deleted later
+    for (auto & model : this->world->Models()) {
+        this->entities.insert(model->GetName());
+        this->initial_models.insert(model->GetName());
+    }
+    for (auto & light : this->world->Lights()) {
+        this->initial_lights.emplace(light->GetName(), light->WorldPose());
+    }
+    this->addConnection = event::Events::ConnectAddEntity(
+        std::bind(&WorldUtils::onAddEntity, this, std::placeholders::_1));
+    this->deleteConnection = event::Events::ConnectDeleteEntity(
+        std::bind(&WorldUtils::onDeleteEntity, this, std::placeholders::_1));
 
     // Connect to the world update signal
     this->updateConnection = event::Events::ConnectPreRender(
@@ -69,50 +100,271 @@ void WorldUtils::Load(physics::WorldPtr _world, sdf::ElementPtr _sdf){
 /////////////////////////////////////////////////
 void WorldUtils::onUpdate()
 {
-    gap::msgs::WorldUtilsResponse msg;
-    bool moved = false;
-
     std::lock_guard<std::mutex> lock(this->mutex);
 
-    // Process queue of objects with pending move
+    // Restore initial entities before any request issued after a reset
+    if (this->reset_pending) {
+        restoreInitial();
+        this->reset_pending = false;
+    }
+
+    // Process queue of requests with pending move
     while (! this->move_queue.empty())
     {
-        MoveObject mv_obj = this->move_queue.front();
-        if (mv_obj.is_light) {
-            physics::LightPtr light = this->world->LightByName(mv_obj.name);
-            if (light) {
-                
-                msgs::Light msg;
-                msg.set_name(mv_obj.name);
-                gazebo::msgs::Pose *pose_msg = new gazebo::msgs::Pose();
-                gazebo::msgs::Set(pose_msg, mv_obj.pose);
-                msg.set_allocated_pose(pose_msg);
-                this->light_pub->Publish(msg);
-
-                /*
-                gzdbg << "Moving light " << light->GetName()
-                    << " to " << mv_obj.pose << std::endl;
-                */
+        const MoveRequest & request = this->move_queue.front();
+
+        gap::msgs::WorldUtilsResponse msg;
+        msg.set_type(MOVED);
+        if (request.has_id) {
+            msg.set_id(request.id);
+        }
+
+        {
+            // Apply every move in the request within the same physics step
+            boost::recursive_mutex::scoped_lock physics_lock(
+                *this->world->Physics()->GetPhysicsUpdateMutex());
+
+            for (const MoveObject & mv_obj : request.objects)
+            {
+                bool success = false;
+                if (mv_obj.is_light) {
+                    success = moveLight(mv_obj.name, mv_obj.pose);
+                } else {
+                    physics::ModelPtr model = modelByName(mv_obj.name);
+                    if (model) {
+                        model->SetWorldPose(mv_obj.pose);
+                        success = true;
+                    }
+                }
+                msg.add_name(mv_obj.name);
+                msg.add_success(success);
+            }
+        }
+
+        // Report status of each object
+        this->pub->Publish(msg);
+        this->move_queue.pop();
+    }
+
+    // Park models removed in pool mode
+    while (! this->park_queue.empty())
+    {
+        const std::string & name = this->park_queue.front();
+        physics::ModelPtr model = modelByName(name);
+        if (model) {
+            this->parked_poses[name] = model->WorldPose();
+            model->SetWorldPose(this->park_pose);
+            model->ResetPhysicsStates();
+            model->SetEnabled(false);
+        }
+        this->park_queue.pop();
+    }
+
+    // Restore parked models which were spawned again
+    while (! this->unpark_queue.empty())
+    {
+        MoveObject mv_obj = this->unpark_queue.front();
+        physics::ModelPtr model = modelByName(mv_obj.name);
+        if (model) {
+            // Without a requested pose, model returns to where it was parked
+            auto it = this->parked_poses.find(mv_obj.name);
+            if (!mv_obj.has_pose && it != this->parked_poses.end()) {
+                mv_obj.pose = it->second;
             }
+            model->SetWorldPose(mv_obj.pose);
+            model->ResetPhysicsStates();
+            model->SetEnabled(true);
+        }
+        this->unpark_queue.pop();
+    }
+
+    insertDeferred();
+    checkRequests();
+}
+
+/////////////////////////////////////////////////
+bool WorldUtils::moveLight(
+    const std::string & _name,
+    const ignition::math::Pose3d & _pose)
+{
+    physics::LightPtr light = this->world->LightByName(_name);
+    if (!light) {
+        return false;
+    }
+    light->SetWorldPose(_pose);
+
+    // Update local rendering scene directly, as this runs before rendering
+    rendering::ScenePtr scene = rendering::get_scene();
+    if (scene) {
+        rendering::LightPtr render_light = scene->LightByName(_name);
+        if (render_light) {
+            render_light->SetPosition(_pose.Pos());
+            render_light->SetRotation(_pose.Rot());
+        }
+    }
+
+    return true;
+}
+
+/////////////////////////////////////////////////
+void WorldUtils::onAddEntity(const std::string & _name)
+{
+    std::lock_guard<std::mutex> lock(this->entities_mutex);
+    this->entities.insert(_name);
+}
+
+/////////////////////////////////////////////////
+void WorldUtils::onDeleteEntity(const std::string & _name)
+{
+    std::lock_guard<std::mutex> lock(this->entities_mutex);
+    this->entities.erase(_name);
+    this->models.erase(_name);
+    this->deleting.erase(_name);
+}
+
+/////////////////////////////////////////////////
+physics::ModelPtr WorldUtils::modelByName(const std::string & _name)
+{
+    std::lock_guard<std::mutex> lock(this->entities_mutex);
+
+    auto it = this->models.find(_name);
+    if (it != this->models.end()) {
+        return it->second;
+    }
+
+    physics::ModelPtr model = this->world->ModelByName(_name);
+    if (model) {
+        this->models.emplace(_name, model);
+    }
+    return model;
+}
+
+/////////////////////////////////////////////////
+void WorldUtils::insertDeferred()
+{
+    if (this->deferred.empty()) {
+        return;
+    }
+
+    rendering::ScenePtr scene = rendering::get_scene();
+    common::Time now = common::Time::GetWallTime();
+
+    auto it = this->deferred.begin();
+    while (it != this->deferred.end())
+    {
+        const std::string & name = it->first;
+        bool gone;
+        {
+            std::lock_guard<std::mutex> lock(this->entities_mutex);
+            // Confirm removal in the world, should the event be missed
+            if (!this->world->ModelByName(name) &&
+                !this->world->LightByName(name)) {
+                this->deleting.erase(name);
+            }
+            gone = !this->deleting.count(name);
+        }
+        gone = gone && !(scene && scene->GetVisual(name));
+
+        if (gone) {
+            this->world->InsertModelString(it->second.sdf);
+            it = this->deferred.erase(it);
+        } else if (now > it->second.deadline) {
+            gzwarn << "[WorldUtils] Timed out waiting for removal of "
+                << name << std::endl;
+            it = this->deferred.erase(it);
         } else {
-            physics::ModelPtr model = this->world->ModelByName(mv_obj.name);
-            if (model) {
-                model->SetWorldPose(mv_obj.pose);
-                /*
-                gzdbg << "Moving model " << model->GetName()
-                    << " to " << mv_obj.pose << std::endl;
-                */
+            ++it;
+        }
+    }
+}
+
+/////////////////////////////////////////////////
+void WorldUtils::dropDeferred()
+{
+    for (auto & request : this->pending)
+    {
+        if (request.removal) {
+            continue;
+        }
+        for (std::size_t i = 0; i < request.names.size(); i++) {
+            if (!request.done[i] && this->deferred.count(request.names[i])) {
+                request.resolve(i, false);
             }
         }
-        this->move_queue.pop();
-        moved = true;
     }
+    this->deferred.clear();
+}
+
+/////////////////////////////////////////////////
+void WorldUtils::checkRequests()
+{
+    if (this->pending.empty()) {
+        return;
+    }
+
+    rendering::ScenePtr scene = rendering::get_scene();
+    common::Time now = common::Time::GetWallTime();
+
+    auto it = this->pending.begin();
+    while (it != this->pending.end())
+    {
+        PendingRequest & request = *it;
+        for (std::size_t i = 0; i < request.names.size(); i++)
+        {
+            if (request.done[i]) continue;
+
+            // Custom SDF spawned as model may contain a light instead
+            const std::string & name = request.names[i];
+            bool in_world, in_scene;
+            if (request.is_light[i] || this->world->LightByName(name)) {
+                in_world = !!this->world->LightByName(name);
+                in_scene = scene && scene->LightByName(name);
+            } else {
+                std::lock_guard<std::mutex> lock(this->entities_mutex);
+                in_world = this->entities.count(name);
+                in_scene = scene && scene->GetVisual(name);
+
+                // Confirm removal in the world, should the event be missed
+                if (request.removal && in_world && !this->world->ModelByName(name)) {
+                    this->entities.erase(name);
+                    this->models.erase(name);
+                    in_world = false;
+                }
+            }
+
+            // Spawned entities need a visual, removed ones must lose it.
+            // Deferred models are not inserted yet, despite their namesakes
+            bool resolved = (request.removal)?
+                (!in_world && !in_scene) :
+                (in_world && (!scene || in_scene) && !this->deferred.count(name));
+
+            if (resolved) {
+                request.resolve(i, true);
+            } else if (now > request.deadline) {
+                gzwarn << "[WorldUtils] Timed out " <<
+                    ((request.removal)? "removing " : "spawning ") <<
+                    name << std::endl;
+                request.resolve(i, false);
+            }
+        }
+
+        if (!request.complete()) {
+            ++it;
+            continue;
+        }
 
-    // TODO - report each object individually
-    // Report sucess in move
-    if (moved) {
-        msg.set_type(SUCCESS);
+        // Report request completion
+        gap::msgs::WorldUtilsResponse msg;
+        msg.set_type((request.removal)? REMOVED : SPAWNED);
+        if (request.has_id) {
+            msg.set_id(request.id);
+        }
+        for (std::size_t i = 0; i < request.names.size(); i++) {
+            msg.add_name(request.names[i]);
+            msg.add_success(request.success[i]);
+        }
         this->pub->Publish(msg);
+        it = this->pending.erase(it);
     }
 }
 
@@ -125,23 +377,30 @@ void WorldUtils::onRequest(WorldUtilsRequestPtr &_msg){
     int model_type;
     std::string name;
     ignition::math::Vector3d pos(0,0,0);
-    ignition::math::Quaterniond ori(0,0,0,0);
-    double mass;
-    std::string texture_uri;
-    std::string texture_name;
+    ignition::math::Quaterniond ori(1,0,0,0);
+    double mass {1.0};
     double radius;
     double length;
-    ignition::math::Vector3d box_size(0,0,0);
+    ignition::math::Vector3d box_size(1,1,1);
 
-    std::string sdf_string;
+    sdf::ElementPtr model;
 
     type = (_msg->has_type())? (_msg->type()) : -1;
 
     if (type == SPAWN){
 
+        // Entities to be acknowledged once present in the world
+        PendingRequest spawn(this->timeout);
+        spawn.has_id = _msg->has_id();
+        spawn.id = _msg->id();
+
+        // Custom objects in request
+        std::vector<const gap::msgs::Object *> custom;
+
         for (int i = 0; i < _msg->object_size(); i++){
             model_type = (_msg->object(i).has_model_type())?
                 (_msg->object(i).model_type()) : -1;
+            model.reset();
 
             /// Extract parameters from message
             if (_msg->object(i).has_pose()){
@@ -159,7 +418,7 @@ void WorldUtils::onRequest(WorldUtilsRequestPtr &_msg){
                 radius = _msg->object(i).has_radius()?
                     _msg->object(i).radius() : 1.0;
 
-                sdf_string = genSphere(name, mass, radius, pos, ori);
+                model = genSphere(name, mass, radius, pos, ori);
 
             } else if (model_type == CYLINDER){
 
@@ -170,7 +429,7 @@ void WorldUtils::onRequest(WorldUtilsRequestPtr &_msg){
                 length = _msg->object(i).has_length()?
                     _msg->object(i).length() : 1.0;
 
-                sdf_string = genCylinder(name, mass, radius, length, pos, ori);
+                model = genCylinder(name, mass, radius, length, pos, ori);
 
             } else if (model_type == BOX){
 
@@ -179,12 +438,12 @@ void WorldUtils::onRequest(WorldUtilsRequestPtr &_msg){
                 if (_msg->object(i).has_box_size())
                     box_size = msgs::ConvertIgn(_msg->object(i).box_size());
 
-                sdf_string = genBox(name, mass, box_size, pos, ori);
+                model = genBox(name, mass, box_size, pos, ori);
 
             } else if (model_type == CUSTOM || model_type == CUSTOM_LIGHT){
 
-                sdf_string = _msg->object(i).has_sdf()?
-                    _msg->object(i).sdf() : "";
+                // Custom objects are processed as a batch, after primitives
+                custom.push_back(&_msg->object(i));
 
             } else if (model_type == MODEL){
 
@@ -194,68 +453,62 @@ void WorldUtils::onRequest(WorldUtilsRequestPtr &_msg){
                 }
             }
 
-            /// If a spawn message was requested
-            if (!sdf_string.empty()){
-
-                std::ostringstream model_str;
-
-                if (model_type != CUSTOM && model_type != CUSTOM_LIGHT) {
-                    /// Enclose in sdf xml tags
-                    model_str << "<sdf version='" << SDF_VERSION << "'>"
-                    << sdf_string << "</sdf>";
-
-                } else {
-
-                    /// Regex to modify pose string in custom model
-                    if (_msg->object(i).has_pose()){
-
-                        ignition::math::Vector3d rpy = ori.Euler();
-
-                        std::ostringstream pose_xml;
-                        pose_xml <<
-                            "<pose>" <<
-                            pos.X() << " " << pos.Y() << " " << pos.Z() << " " <<
-                            rpy.X() << " " << rpy.Y() << " " << rpy.Z() <<
-                            "</pose>";
+            /// If a primitive was requested
+            if (model){
 
-                        std::string new_model_str = std::regex_replace(
-                            sdf_string, this->pose_reg, pose_xml.str());
-
-                        model_str << new_model_str;
+                if (_msg->object(i).has_texture_uri() && _msg->object(i).has_texture_name()){
 
-                    } else {
-                        model_str << sdf_string;
-                    }
+                    /// Set material script in visual
+                    sdf::ElementPtr script = model->GetElement("link")->
+                        GetElement("visual")->GetElement("material")->GetElement("script");
+                    script->GetElement("uri")->Set(_msg->object(i).texture_uri());
+                    script->GetElement("name")->Set(_msg->object(i).texture_name());
                 }
 
-                std::string new_model_str;
-
-                if (_msg->object(i).has_texture_uri() && _msg->object(i).has_texture_name()){
+                // Insert model in World
+                sdf::SDF objectSDF;
+                objectSDF.Root(model);
+                this->world->InsertModelSDF(objectSDF);
+                spawn.add(name, false);
+            }
+        }
 
-                    /// Change material script in string
-                    texture_uri = _msg->object(i).texture_uri();
-                    texture_name = _msg->object(i).texture_name();
+        spawnCustom(custom, spawn);
 
-                    std::string texture_str =
-                        "<script><uri>" + texture_uri + "</uri>" +
-                        "<name>" + texture_name + "</name></script>";
+        if (!spawn.names.empty()) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->pending.push_back(spawn);
+        }
 
-                    new_model_str = std::regex_replace(
-                        model_str.str(), this->script_reg, texture_str);
+    } else if (type == REGISTER) {
 
-                } else {
-                    new_model_str = model_str.str();
+        for (int i = 0; i < _msg->object_size(); i++)
+        {
+            const gap::msgs::Object & object = _msg->object(i);
+            if (!object.has_template_id() || !object.has_sdf()) {
+                continue;
+            }
+            // Keep identifier of unchanged templates, so that models parked
+            // by previous clients are reused
+            auto it = this->registered.find(object.template_id());
+            if (it != this->registered.end())
+            {
+                if (it->second.matches(object.sdf())) {
+                    continue;
                 }
-
-                // Insert model in World
-                sdf::SDF objectSDF;
-                objectSDF.SetFromString(new_model_str);
-                this->world->InsertModelSDF(objectSDF);
+                forgetTemplates({it->second.id});
+                this->registered.erase(it);
             }
+            this->registered.emplace(
+                object.template_id(), SDFTemplate(object.sdf()));
         }
 
     } else if (type == MOVE) {
 
+        MoveRequest request;
+        request.has_id = _msg->has_id();
+        request.id = _msg->id();
+
         for (int i = 0; i < _msg->object_size(); i++)
         {
             model_type = (_msg->object(i).has_model_type())? (_msg->object(i).model_type()) : -1;
@@ -265,30 +518,65 @@ void WorldUtils::onRequest(WorldUtilsRequestPtr &_msg){
                 msgs::Pose m_pose = _msg->object(i).pose();
                 ignition::math::Pose3d pose(msgs::ConvertIgn(m_pose));
 
-                std::lock_guard<std::mutex> lock(this->mutex);
-
                 bool is_light = (model_type == CUSTOM_LIGHT);
-                this->move_queue.emplace(name, is_light, pose);
+                request.objects.emplace_back(name, is_light, pose);
             }
         }
 
+        // Every object in the request is moved in the same update
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->move_queue.push(request);
+
     } else if (type == REMOVE) {
 
-        if(_msg->object_size() > 0) {
+        // Entities to be acknowledged once gone from the world
+        PendingRequest removal(this->timeout);
+        removal.removal = true;
+        removal.has_id = _msg->has_id();
+        removal.id = _msg->id();
 
-            for (int i = 0; i < _msg->object_size(); i++) {
-                model_type = (_msg->object(i).has_model_type())? (_msg->object(i).model_type()) : -1;
-                if (_msg->object(i).has_name()){
-                    // Clear specific object(s)
-                    clearMatching(_msg->object(i).name() , (model_type == CUSTOM_LIGHT));
+        int match = (_msg->has_match())? _msg->match() : CONTAINS;
+        std::vector<std::string> model_patterns;
+        std::vector<std::string> light_patterns;
+        bool clear = (_msg->object_size() == 0);
+
+        for (int i = 0; i < _msg->object_size(); i++) {
+            model_type = (_msg->object(i).has_model_type())? (_msg->object(i).model_type()) : -1;
+            if (_msg->object(i).has_name()){
+                // Clear specific object(s)
+                if (model_type == CUSTOM_LIGHT) {
+                    light_patterns.push_back(_msg->object(i).name());
                 } else {
-                    // Clear everything
-                    clearWorld();
+                    model_patterns.push_back(_msg->object(i).name());
                 }
+            } else {
+                // Clear everything
+                clear = true;
             }
+        }
+
+        if (clear) {
+            clearWorld(removal);
         } else {
-            clearWorld();
+            clearMatching(model_patterns, match, false, removal);
+            clearMatching(light_patterns, match, true, removal);
         }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->pending.push_back(removal);
+
+    } else if (type == RESET) {
+
+        // Entities to be acknowledged once gone from the world
+        PendingRequest removal(this->timeout);
+        removal.removal = true;
+        removal.has_id = _msg->has_id();
+        removal.id = _msg->id();
+
+        resetWorld(removal);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->pending.push_back(removal);
     }
 
     else if (type == PHYSICS) {
@@ -316,68 +604,585 @@ void WorldUtils::onRequest(WorldUtilsRequestPtr &_msg){
         int light_count = this->world->LightCount();
         msg.set_type(INFO);
         msg.set_object_count(model_count + light_count);
+        if (_msg->has_id()) {
+            msg.set_id(_msg->id());
+        }
+
+        // List entities matching the names of request objects, if any
+        if (_msg->has_list() && _msg->list()) {
+
+            std::vector<std::string> patterns;
+            for (int i = 0; i < _msg->object_size(); i++) {
+                if (_msg->object(i).has_name()) {
+                    patterns.push_back(_msg->object(i).name());
+                }
+            }
+            try {
+                NameFilter filter(patterns,
+                    (_msg->has_match())? _msg->match() : CONTAINS);
+                listEntities(filter, msg);
+            } catch (const std::regex_error & e) {
+                gzerr << "[WorldUtils] Invalid status pattern: "
+                    << e.what() << std::endl;
+            }
+        }
         pub->Publish(msg,true);
     }
 }
 
 /////////////////////////////////////////////////
-void WorldUtils::clearWorld(){
+void WorldUtils::spawnCustom(
+    const std::vector<const gap::msgs::Object *> & _objs,
+    PendingRequest & _request)
+{
+    const std::size_t n = _objs.size();
+    if (n == 0) {
+        return;
+    }
 
-    this->world->Clear();
+    // Pre-process distinct uncached SDF strings in parallel
+    std::vector<std::string> distinct;
+    std::vector<std::string> fresh;
+    {
+        std::unordered_set<std::string> seen;
+        for (const auto *obj : _objs) {
+            if (!obj->has_template_id() && obj->has_sdf() &&
+                seen.insert(obj->sdf()).second) {
+                distinct.push_back(obj->sdf());
+                if (!this->templates.count(obj->sdf())) {
+                    fresh.push_back(obj->sdf());
+                }
+            }
+        }
+    }
+    // Bound memory usage with many distinct custom objects
+    if (this->templates.size() + fresh.size() > MAX_TEMPLATES) {
+        evictTemplates();
+        fresh.swap(distinct);
+    }
+    if (!fresh.empty())
+    {
+        std::vector<std::unique_ptr<SDFTemplate>> built(fresh.size());
+        this->worker_pool->parallelFor(fresh.size(), [&](std::size_t i) {
+            built[i].reset(new SDFTemplate(fresh[i]));
+        });
+        for (std::size_t i = 0; i < fresh.size(); i++) {
+            this->templates.emplace(fresh[i], std::move(*built[i]));
+        }
+    }
+
+    // Resolve template and name of each object, reusing parked models
+    std::vector<const SDFTemplate *> tmpls(n, nullptr);
+    std::vector<std::string> names(n);
+    std::vector<bool> reused(n, false);
+
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const gap::msgs::Object & obj = *_objs[i];
+
+        // Report failures with requested name, or template id if not provided
+        names[i] = obj.has_name()? obj.name() : obj.template_id();
+
+        if (obj.has_template_id()) {
+            auto it = this->registered.find(obj.template_id());
+            if (it == this->registered.end()) {
+                gzwarn << "[WorldUtils] Unknown template "
+                    << obj.template_id() << std::endl;
+                continue;
+            }
+            tmpls[i] = &it->second;
+        } else if (obj.has_sdf()) {
+            tmpls[i] = &this->templates.at(obj.sdf());
+        } else {
+            continue;
+        }
+
+        // Name of spawned entity, either overriden or from template
+        if (!obj.has_name()) {
+            names[i] = tmpls[i]->name();
+        }
+
+        reused[i] = this->pool && unparkModel(*tmpls[i], obj);
+    }
+
+    // Instantiate and validate SDF strings in parallel
+    std::vector<std::string> sdf_strings(n);
+    std::vector<char> valid(n, true);
+
+    this->worker_pool->parallelFor(n, [&](std::size_t i)
+    {
+        if (!tmpls[i] || reused[i]) {
+            return;
+        }
+        sdf_strings[i] = tmpls[i]->instantiate(overridesFor(*_objs[i]));
+
+        if (this->validate)
+        {
+            sdf::SDFPtr check(new sdf::SDF());
+            check->Root(this->description->Clone());
+            valid[i] = sdf::readString(sdf_strings[i], check) &&
+                (check->Root()->HasElement("model") ||
+                 check->Root()->HasElement("light"));
+        }
+    });
+
+    // Insert models in World, in order
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const gap::msgs::Object & obj = *_objs[i];
+        const bool is_light = (obj.model_type() == CUSTOM_LIGHT);
+
+        if (names[i].empty()) {
+            continue;
+        }
+        if (!tmpls[i] || !valid[i]) {
+            if (!valid[i]) {
+                gzwarn << "[WorldUtils] Invalid SDF for " << names[i] << std::endl;
+            }
+            _request.add(names[i], is_light, true);
+            continue;
+        }
+
+        if (!reused[i])
+        {
+            if (this->pool && !is_light) {
+                // Delete parked model from another template with the same name
+                auto it = this->spawned.find(names[i]);
+                if (it != this->spawned.end() &&
+                    this->parked[it->second].erase(names[i])) {
+                    deleteEntity(names[i]);
+                }
+                this->spawned[names[i]] = tmpls[i]->id;
+            }
+
+            // Insert model in World; the world factory parses the string,
+            // so there is no need to build an sdf::SDF object here.
+            // Factory requests may overtake deletions, so a model named
+            // after an entity being deleted waits for it to be gone
+            bool namesake;
+            {
+                std::lock_guard<std::mutex> lock(this->entities_mutex);
+                namesake = this->deleting.count(names[i]);
+            }
+            if (namesake) {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                DeferredModel & model = this->deferred[names[i]];
+                model.sdf = sdf_strings[i];
+                model.deadline = _request.deadline;
+            } else {
+                this->world->InsertModelString(sdf_strings[i]);
+            }
+        }
+        _request.add(names[i], is_light);
+    }
+}
+
+/////////////////////////////////////////////////
+SDFOverrides WorldUtils::overridesFor(const gap::msgs::Object & _obj)
+{
+    SDFOverrides overrides;
+
+    if (_obj.has_name()) {
+        overrides.name = _obj.name();
+    }
+    if (_obj.has_pose()) {
+        ignition::math::Vector3d pos = msgs::ConvertIgn(_obj.pose().position());
+        ignition::math::Vector3d rpy =
+            msgs::ConvertIgn(_obj.pose().orientation()).Euler();
+
+        std::ostringstream pose_xml;
+        pose_xml <<
+            "<pose>" <<
+            pos.X() << " " << pos.Y() << " " << pos.Z() << " " <<
+            rpy.X() << " " << rpy.Y() << " " << rpy.Z() <<
+            "</pose>";
+        overrides.pose = pose_xml.str();
+    }
+    if (_obj.has_texture_uri() && _obj.has_texture_name()) {
+        overrides.script =
+            "<script><uri>" + _obj.texture_uri() + "</uri>" +
+            "<name>" + _obj.texture_name() + "</name></script>";
+    }
+    if (_obj.has_scale()) {
+        ignition::math::Vector3d scale = msgs::ConvertIgn(_obj.scale());
+
+        std::ostringstream scale_xml;
+        scale_xml << "<scale>" <<
+            scale.X() << " " << scale.Y() << " " << scale.Z() << "</scale>";
+        overrides.scale = scale_xml.str();
+    }
+    return overrides;
 }
 
 /////////////////////////////////////////////////
-void WorldUtils::clearMatching(const std::string &match, const bool is_light){
+bool WorldUtils::unparkModel(
+    const SDFTemplate & _tmpl,
+    const gap::msgs::Object & _obj)
+{
+    auto it = this->parked.find(_tmpl.id);
+    if (it == this->parked.end() || it->second.empty()) {
+        return false;
+    }
+    std::set<std::string> & names = it->second;
+
+    // Models cannot be renamed, so a requested name must match exactly
+    std::string name;
+    if (_obj.has_name()) {
+        if (!names.count(_obj.name())) {
+            return false;
+        }
+        name = _obj.name();
+    } else {
+        name = *names.begin();
+    }
+    names.erase(name);
 
-    std::string entity_name;
-    std::string match_str = match;
-    gazebo::msgs::Request *msg;
+    ignition::math::Pose3d pose;
+    if (_obj.has_pose()) {
+        pose = msgs::ConvertIgn(_obj.pose());
+    }
 
-    if (is_light){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->unpark_queue.emplace(name, false, pose);
+    this->unpark_queue.back().has_pose = _obj.has_pose();
+    return true;
+}
 
-        physics::Light_V lights = this->world->Lights();
-        for (auto &l : lights){
-            entity_name = l->GetName();
-            if (entity_name.find(match_str) != std::string::npos){
-                msg = gazebo::msgs::CreateRequest("entity_delete", entity_name);
-                request_pub->Publish(*msg, true);
+/////////////////////////////////////////////////
+void WorldUtils::evictTemplates()
+{
+    std::unordered_set<unsigned int> evicted;
+    for (const auto & tmpl : this->templates) {
+        evicted.insert(tmpl.second.id);
+    }
+    forgetTemplates(evicted);
+    this->templates.clear();
+}
+
+/////////////////////////////////////////////////
+void WorldUtils::forgetTemplates(const std::unordered_set<unsigned int> & _ids)
+{
+    for (const auto & id : _ids)
+    {
+        auto it = this->parked.find(id);
+        if (it == this->parked.end()) {
+            continue;
+        }
+        for (const auto & name : it->second) {
+            deleteEntity(name);
+        }
+        this->parked.erase(it);
+    }
+    for (auto it = this->spawned.begin(); it != this->spawned.end(); )
+    {
+        if (_ids.count(it->second)) {
+            it = this->spawned.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/////////////////////////////////////////////////
+void WorldUtils::resetWorld(PendingRequest & _request)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        // Drop operations queued for the previous state, parked models
+        // awaiting reuse simply remain parked. Dropped moves are reported
+        // as failed, so that clients waiting on them need not time out
+        while (!this->move_queue.empty())
+        {
+            const MoveRequest & request = this->move_queue.front();
+            gap::msgs::WorldUtilsResponse msg;
+            msg.set_type(MOVED);
+            if (request.has_id) {
+                msg.set_id(request.id);
+            }
+            for (const MoveObject & mv_obj : request.objects) {
+                msg.add_name(mv_obj.name);
+                msg.add_success(false);
             }
+            this->pub->Publish(msg);
+            this->move_queue.pop();
+        }
+        std::queue<MoveObject>().swap(this->unpark_queue);
+        dropDeferred();
+        this->reset_pending = true;
+    }
+
+    // Automatic names start over
+    this->sphere_counter = 0;
+    this->cylinder_counter = 0;
+    this->box_counter = 0;
+    this->light_counter = 0;
+
+    // Remove entities added since load
+    std::vector<std::string> models;
+    std::vector<std::string> lights;
+    for (auto & model : this->world->Models()) {
+        if (!this->initial_models.count(model->GetName())) {
+            models.push_back(model->GetName());
+        }
+    }
+    for (auto & light : this->world->Lights()) {
+        if (!this->initial_lights.count(light->GetName())) {
+            lights.push_back(light->GetName());
+        }
+    }
+    clearMatching(models, EXACT, false, _request);
+    clearMatching(lights, EXACT, true, _request);
+}
+
+/////////////////////////////////////////////////
+void WorldUtils::restoreInitial()
+{
+    boost::recursive_mutex::scoped_lock physics_lock(
+        *this->world->Physics()->GetPhysicsUpdateMutex());
+
+    for (const auto & name : this->initial_models) {
+        physics::ModelPtr model = modelByName(name);
+        if (model) {
+            model->Reset();
         }
+    }
+    for (const auto & light : this->initial_lights) {
+        moveLight(light.first, light.second);
+    }
+    this->world->ResetTime();
+}
+
+/////////////////////////////////////////////////
+void WorldUtils::listEntities(
+    const NameFilter & _filter,
+    gap::msgs::WorldUtilsResponse & _msg)
+{
+    // Read every pose in the same physics step
+    boost::recursive_mutex::scoped_lock lock(
+        *this->world->Physics()->GetPhysicsUpdateMutex());
+
+    auto add = [&](const std::string & name,
+        const ignition::math::Pose3d & pose, bool is_light)
+    {
+        _msg.add_name(name);
+        _msg.add_pose(pose.Pos().X());
+        _msg.add_pose(pose.Pos().Y());
+        _msg.add_pose(pose.Pos().Z());
+        _msg.add_pose(pose.Rot().W());
+        _msg.add_pose(pose.Rot().X());
+        _msg.add_pose(pose.Rot().Y());
+        _msg.add_pose(pose.Rot().Z());
+        _msg.add_light(is_light);
+    };
+
+    for (auto & model : this->world->Models()) {
+        if (_filter(model->GetName())) {
+            add(model->GetName(), model->WorldPose(), false);
+        }
+    }
+    for (auto & light : this->world->Lights()) {
+        if (_filter(light->GetName())) {
+            add(light->GetName(), light->WorldPose(), true);
+        }
+    }
+}
+
+/////////////////////////////////////////////////
+void WorldUtils::clearWorld(PendingRequest & _request){
+
+    // Entities are deleted one by one rather than with World::Clear, which
+    // returns at once, so that the request is acknowledged only once every
+    // entity is gone. Parked models are deleted as well
+    for (auto & model : this->world->Models()) {
+        deleteEntity(model->GetName());
+        _request.add(model->GetName(), false);
+    }
+    for (auto & light : this->world->Lights()) {
+        deleteEntity(light->GetName());
+        _request.add(light->GetName(), true);
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->entities_mutex);
+        this->models.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        dropDeferred();
+        this->parked_poses.clear();
+    }
+    this->spawned.clear();
+    this->parked.clear();
+}
+
+/////////////////////////////////////////////////
+void WorldUtils::clearMatching(
+    const std::vector<std::string> & _patterns,
+    const int _match,
+    const bool _is_light,
+    PendingRequest & _request){
+
+    if (_patterns.empty()) {
+        return;
+    }
 
+    // Prepare patterns once for every entity
+    std::unique_ptr<NameFilter> filter;
+    try {
+        filter.reset(new NameFilter(_patterns, _match));
+    } catch (const std::regex_error & e) {
+        gzerr << "[WorldUtils] Invalid removal pattern: "
+            << e.what() << std::endl;
+        return;
+    }
+    const NameFilter & matches = *filter;
+
+    // Gather names of matching entities
+    std::vector<std::string> names;
+    if (_match == EXACT) {
+        // Explicit names need no scan of the world
+        for (const auto & name : _patterns) {
+            if ((_is_light)? !!this->world->LightByName(name) : !!modelByName(name)) {
+                names.push_back(name);
+            }
+        }
+    } else if (_is_light) {
+        for (auto & light : this->world->Lights()) {
+            if (matches(light->GetName())) {
+                names.push_back(light->GetName());
+            }
+        }
     } else {
+        for (auto & model : this->world->Models()) {
+            if (matches(model->GetName())) {
+                names.push_back(model->GetName());
+            }
+        }
+    }
 
-        physics::Model_V models = this->world->Models();
-        for (auto &m : models){
-            entity_name = m->GetName();
-            if (entity_name.find(match_str) != std::string::npos){
-                msg = gazebo::msgs::CreateRequest("entity_delete", entity_name);
-                request_pub->Publish(*msg, true);
+    for (const auto & name : names)
+    {
+        if (!_is_light) {
+            auto it = this->spawned.find(name);
+            if (it != this->spawned.end())
+            {
+                if (this->pool) {
+                    // Park model for later reuse, it is never deleted
+                    std::set<std::string> & parked_names = this->parked[it->second];
+                    if (parked_names.insert(name).second) {
+                        std::lock_guard<std::mutex> lock(this->mutex);
+                        this->park_queue.push(name);
+                    }
+                    _request.add(name, false);
+                    _request.resolve(_request.names.size() - 1, true);
+                    continue;
+                }
+                this->spawned.erase(it);
             }
         }
+
+        deleteEntity(name);
+        _request.add(name, _is_light);
     }
+}
 
-    delete msg;
+/////////////////////////////////////////////////
+void WorldUtils::deleteEntity(const std::string & _name)
+{
+    // Request is queued in the publisher, rather than waiting for delivery
+    msgs::Request msg;
+    msg.set_id(ignition::math::Rand::IntUniform(1, 10000));
+    msg.set_request("entity_delete");
+    msg.set_data(_name);
+    {
+        std::lock_guard<std::mutex> lock(this->entities_mutex);
+        this->deleting.insert(_name);
+    }
+    this->request_pub->Publish(msg, false);
 }
 
 /////////////////////////////////////////////////
-const std::string WorldUtils::genSphere(
+sdf::ElementPtr WorldUtils::primitive(const int _type)
+{
+    auto it = this->primitives.find(_type);
+    if (it == this->primitives.end())
+    {
+        msgs::Model model;
+        model.set_name("unit");
+        if (_type == SPHERE) {
+            msgs::AddSphereLink(model, 1.0, 1.0);
+        } else if (_type == CYLINDER) {
+            msgs::AddCylinderLink(model, 1.0, 1.0, 1.0);
+        } else {
+            msgs::AddBoxLink(model, 1.0, ignition::math::Vector3d::One);
+        }
+        it = this->primitives.emplace(_type, msgs::ModelToSDF(model)).first;
+    }
+    return it->second->Clone();
+}
+
+/////////////////////////////////////////////////
+/// \brief Sets name, pose and inertial properties of a primitive model
+/// \param _model       Model SDF element
+/// \param _name        Model name
+/// \param _pose        Model pose
+/// \param _mass        Model mass
+/// \param _inertia     Principal moments of inertia
+static void setModel(
+    sdf::ElementPtr _model,
+    const std::string & _name,
+    const ignition::math::Pose3d & _pose,
+    const double _mass,
+    const ignition::math::Vector3d & _inertia)
+{
+    _model->GetAttribute("name")->Set(_name);
+    _model->GetElement("pose")->Set(_pose);
+
+    sdf::ElementPtr inertial = _model->GetElement("link")->GetElement("inertial");
+    inertial->GetElement("mass")->Set(_mass);
+    sdf::ElementPtr inertia = inertial->GetElement("inertia");
+    inertia->GetElement("ixx")->Set(_inertia.X());
+    inertia->GetElement("iyy")->Set(_inertia.Y());
+    inertia->GetElement("izz")->Set(_inertia.Z());
+}
+
+/////////////////////////////////////////////////
+/// \brief Sets a geometry parameter in both collision and visual of a primitive
+/// \param _model   Model SDF element
+/// \param _shape   Geometry shape element name
+/// \param _param   Parameter element name
+/// \param _value   Parameter value
+template <typename T>
+static void setShape(
+    sdf::ElementPtr _model,
+    const std::string & _shape,
+    const std::string & _param,
+    const T & _value)
+{
+    sdf::ElementPtr link = _model->GetElement("link");
+    for (const char *elem : {"collision", "visual"}) {
+        link->GetElement(elem)->GetElement("geometry")->
+            GetElement(_shape)->GetElement(_param)->Set(_value);
+    }
+}
+
+/////////////////////////////////////////////////
+sdf::ElementPtr WorldUtils::genSphere(
     const std::string &model_name,
     const double mass,
     const double radius,
     const ignition::math::Vector3d position,
     const ignition::math::Quaterniond orientation){
 
-    msgs::Model model;
-    model.set_name(model_name);
-    msgs::Set(model.mutable_pose(),
-        ignition::math::Pose3d(position, orientation));
-    msgs::AddSphereLink(model, mass, radius);
-
-    return msgs::ModelToSDF(model)->ToString("");
+    sdf::ElementPtr model = primitive(SPHERE);
+    double i = 0.4 * mass * radius * radius;
+    setModel(model, model_name, ignition::math::Pose3d(position, orientation),
+        mass, ignition::math::Vector3d(i, i, i));
+    setShape(model, "sphere", "radius", radius);
+    return model;
 }
 
 /////////////////////////////////////////////////
-const std::string WorldUtils::genCylinder(
+sdf::ElementPtr WorldUtils::genCylinder(
     const std::string &model_name,
     const double mass,
     const double radius,
@@ -385,30 +1190,30 @@ const std::string WorldUtils::genCylinder(
     const ignition::math::Vector3d position,
     const ignition::math::Quaterniond orientation){
 
-    msgs::Model model;
-    model.set_name(model_name);
-    msgs::Set(model.mutable_pose(),
-        ignition::math::Pose3d(position, orientation));
-    msgs::AddCylinderLink(model, mass, radius, length);
-
-    return msgs::ModelToSDF(model)->ToString("");
-};
+    sdf::ElementPtr model = primitive(CYLINDER);
+    double i = mass * (3 * radius * radius + length * length) / 12.0;
+    setModel(model, model_name, ignition::math::Pose3d(position, orientation),
+        mass, ignition::math::Vector3d(i, i, 0.5 * mass * radius * radius));
+    setShape(model, "cylinder", "radius", radius);
+    setShape(model, "cylinder", "length", length);
+    return model;
+}
 
 /////////////////////////////////////////////////
-const std::string WorldUtils::genBox(
+sdf::ElementPtr WorldUtils::genBox(
     const std::string &model_name,
     const double mass,
     const ignition::math::Vector3d size,
     const ignition::math::Vector3d position,
     const ignition::math::Quaterniond orientation){
 
-    msgs::Model model;
-    model.set_name(model_name);
-    msgs::Set(model.mutable_pose(),
-        ignition::math::Pose3d(position, orientation));
-    msgs::AddBoxLink(model, mass, size);
-
-    return msgs::ModelToSDF(model)->ToString("");
-};
+    sdf::ElementPtr model = primitive(BOX);
+    ignition::math::Vector3d sq = size * size;
+    setModel(model, model_name, ignition::math::Pose3d(position, orientation),
+        mass, mass / 12.0 * ignition::math::Vector3d(
+            sq.Y() + sq.Z(), sq.X() + sq.Z(), sq.X() + sq.Y()));
+    setShape(model, "box", "size", size);
+    return model;
+}
 
 }
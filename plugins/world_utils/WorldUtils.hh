@@ -30,17 +30,27 @@
 #include "gazebo/common/Plugin.hh"
 #include <gazebo/msgs/msgs.hh>
 #include "gazebo/physics/physics.hh"
+#include <gazebo/rendering/rendering.hh>
 #include <gazebo/transport/transport.hh>
+#include <ignition/math/Rand.hh>
 
 // Mutex
 #include <mutex>
+// Worker threads
+#include <functional>
+#include <thread>
 
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <list>
+#include <map>
+#include <set>
 #include <string>
 #include <regex>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
 // Boost
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/lexical_cast.hpp>
@@ -51,6 +61,14 @@
 
 // Õbjects with pending move operations
 #include "MoveObject.hh"
+// Pre-processed custom SDF strings
+#include "SDFTemplate.hh"
+// Spawn and removal requests awaiting completion
+#include "PendingRequest.hh"
+// Entity name matching
+#include "NameFilter.hh"
+// Persistent worker threads
+#include "WorkerPool.hh"
 
 namespace WorldUtils {
 
@@ -75,6 +93,19 @@ namespace WorldUtils {
 #define PAUSE           gap::msgs::WorldUtilsRequest::PAUSE
 /// Get entity or world information
 #define STATUS          gap::msgs::WorldUtilsRequest::STATUS
+/// Register custom SDF template
+#define REGISTER        gap::msgs::WorldUtilsRequest::REGISTER
+/// Restore world to its state after load
+#define RESET           gap::msgs::WorldUtilsRequest::RESET
+
+/// Remove entities with names containing string
+#define CONTAINS        gap::msgs::WorldUtilsRequest::CONTAINS
+/// Remove entities with names starting with string
+#define PREFIX          gap::msgs::WorldUtilsRequest::PREFIX
+/// Remove entities with names matching regular expression
+#define REGEX           gap::msgs::WorldUtilsRequest::REGEX
+/// Remove entities with given names
+#define EXACT           gap::msgs::WorldUtilsRequest::EXACT
 
 /// Spawn sphere object
 #define SPHERE          gap::msgs::Object::SPHERE
@@ -95,18 +126,23 @@ namespace WorldUtils {
 #define INFO            gap::msgs::WorldUtilsResponse::INFO
 /// \brief TODO
 #define SUCCESS         gap::msgs::WorldUtilsResponse::SUCCESS
-
-// Regex patterns
-
-// Do not raise documentation warning
-//! @cond DoNotRaiseWarning
-
-/// Matches string enclosed in <script> XML tags
-#define REGEX_XML_SCRIPT "<script>[\\s\\S]*?<\\/script>"
-/// Matches string enclosed in <pose> XML tags
-#define REGEX_XML_POSE   "<pose>[\\s\\S]*?<\\/pose>"
-
-//! @endcond
+/// \brief Spawn request completed
+#define SPAWNED         gap::msgs::WorldUtilsResponse::SPAWNED
+/// \brief Move request completed
+#define MOVED           gap::msgs::WorldUtilsResponse::MOVED
+/// \brief Remove request completed
+#define REMOVED         gap::msgs::WorldUtilsResponse::REMOVED
+
+/// Maximum number of cached custom SDF templates
+#define MAX_TEMPLATES   256
+/// Default maximum time to wait for spawned or removed entities, in seconds
+#define TIMEOUT         10.0
+/// Default number of workers for processing spawn requests
+#define WORKERS         std::max(1u, std::thread::hardware_concurrency())
+/// Maximum number of queued gazebo requests, such as entity removals
+#define REQUEST_QUEUE_LIMIT 100000
+/// Default pose of parked entities in pool mode
+#define PARK_POSE       ignition::math::Pose3d(0, 0, -1000, 0, 0, 0)
 
 }
 
@@ -129,6 +165,48 @@ namespace gazebo {
     ///
     /// See worlds/spawner.world for a complete example.
     ///
+    /// Each spawn request is acknowledged with a SPAWNED response, once every
+    /// requested entity and its visual exist, or <timeout> seconds
+    /// elapse. Entities spawned from gazebo model path are not tracked.
+    /// Likewise, each remove request is acknowledged with a REMOVED response,
+    /// once every matching entity is gone. Entities may be matched by
+    /// substring (default), prefix, regular expression or exact name.
+    /// The same criteria filter the entities listed in a STATUS response,
+    /// when requested.
+    /// Objects in a move request are moved in the same physics step, and
+    /// reported individually in a MOVED response.
+    /// Both responses carry the id of the corresponding request, if any.
+    ///
+    /// A reset request restores the world to its state after load, so a
+    /// single server may be reused indefinitely. Entities added since load
+    /// are removed, or parked in pool mode, and the remaining ones return to
+    /// their initial poses. Registered templates are kept. The request is
+    /// acknowledged with a REMOVED response listing the removed entities.
+    /// Move requests not yet applied are dropped, and reported as failed.
+    ///
+    /// Custom objects in spawn requests are processed by <workers> threads.
+    /// Unless <validate> is false, their SDF is checked beforehand, so
+    /// invalid objects are reported right away.
+    ///
+    /// Optionally, the plugin may keep a pool of custom objects, which is
+    /// useful when the same objects are repeatedly removed and spawned:
+    /// \code{.xml}
+    ///    <plugin name="world" filename="libWorldUtils.so">
+    ///      <pool>true</pool>
+    ///      <park_pose>0 0 -1000 0 0 0</park_pose>
+    ///    </plugin>
+    /// \endcode
+    ///
+    /// In pool mode, removing a model spawned from an SDF template parks it
+    /// at park_pose with physics disabled, instead of deleting it.
+    /// Spawning an object from the same template reuses the parked model with
+    /// the requested name, or any parked model if no name is provided.
+    /// Reused models are placed at the requested pose, or where they were
+    /// parked from if none is given, and keep their original material and
+    /// scale, which may be changed with VisualUtils.
+    /// Registering a template id again with the same SDF keeps its parked
+    /// models, whereas a different SDF deletes them.
+    ///
     /// \warning This plugin is likely to undergo major changes, as some
     /// of its features can easily be done client-side.
     class WorldUtils : public WorldPlugin {
@@ -140,6 +218,10 @@ namespace gazebo {
         private: physics::WorldPtr world;
         /// Connection to World Update events
         private: event::ConnectionPtr updateConnection;
+        /// Connection to entity added events
+        private: event::ConnectionPtr addConnection;
+        /// Connection to entity deleted events
+        private: event::ConnectionPtr deleteConnection;
 
         /// A node used for transport
         private: transport::NodePtr node;
@@ -152,15 +234,23 @@ namespace gazebo {
         private: transport::PublisherPtr request_pub;
         /// A subscriber to the gazebo response topic
         private: transport::SubscriberPtr response_sub;
-        /// A publisher to light modify topic
-        private: transport::PublisherPtr light_pub;
 
-        // Regex patterns
+        /// Unit primitive models, indexed by model type
+        private: std::map<int, sdf::ElementPtr> primitives;
+
+        /// Cache of custom SDF templates, indexed by SDF string
+        private: std::unordered_map<std::string, SDFTemplate> templates;
+        /// Custom SDF templates registered by clients, indexed by id
+        private: std::unordered_map<std::string, SDFTemplate> registered;
 
-        /// Regex for applying custom material
-        private: std::regex script_reg;
-        /// Regex for applying custom pose
-        private: std::regex pose_reg;
+        /// Number of workers for processing spawn requests
+        private: unsigned int workers {WORKERS};
+        /// Worker threads, started on load, besides the requesting thread
+        private: std::unique_ptr<WorkerPool> worker_pool;
+        /// Whether custom SDF is validated before insertion in the world
+        private: bool validate {true};
+        /// Empty SDF description, for validation
+        private: sdf::ElementPtr description;
 
         // Counters for automatic naming
 
@@ -173,8 +263,52 @@ namespace gazebo {
         /// Number of generated lights
         private: int light_counter       {0};
 
-        /// Queue of objects with pending move actions
-        private: std::queue<MoveObject> move_queue;
+        /// Queue of requests with pending move actions
+        private: std::queue<MoveRequest> move_queue;
+
+        // World reset
+
+        /// Names of models present after load
+        private: std::set<std::string> initial_models;
+        /// Initial poses of lights present after load, indexed by name
+        private: std::map<std::string, ignition::math::Pose3d> initial_lights;
+        /// Whether initial entities should be restored in the next update
+        private: bool reset_pending {false};
+
+        // Spawn and removal acknowledgement
+
+        /// Mutex for entity tracking, also locked from the physics thread
+        private: std::mutex entities_mutex;
+        /// Names of models present in the world, tracked via entity events
+        private: std::set<std::string> entities;
+        /// Cache of models looked up by name, cleared on entity deletion
+        private: std::unordered_map<std::string, physics::ModelPtr> models;
+        /// Spawn and removal requests awaiting completion
+        private: std::list<PendingRequest> pending;
+        /// Names of entities being deleted, guarded by entities mutex
+        private: std::set<std::string> deleting;
+        /// Models awaiting removal of an entity with the same name
+        private: std::unordered_map<std::string, DeferredModel> deferred;
+        /// Maximum time to wait for spawned or removed entities, in seconds
+        private: double timeout {TIMEOUT};
+
+        // Object pool
+
+        /// Whether removed custom models are parked for reuse
+        private: bool pool {false};
+        /// Pose of parked models
+        private: ignition::math::Pose3d park_pose {PARK_POSE};
+        /// Template identifier of each model spawned from a template
+        private: std::unordered_map<std::string, unsigned int> spawned;
+        /// Names of parked models, indexed by template identifier
+        private: std::unordered_map<unsigned int, std::set<std::string>> parked;
+        /// Queue of models pending park
+        private: std::queue<std::string> park_queue;
+        /// Poses of models when parked, restored if reused without a pose
+        private: std::unordered_map<std::string, ignition::math::Pose3d>
+            parked_poses;
+        /// Queue of parked models pending reuse
+        private: std::queue<MoveObject> unpark_queue;
 
         // Public methods
 
@@ -189,19 +323,137 @@ namespace gazebo {
         /// \brief Callback function for handling world updates
         public: void onUpdate();
 
+        /// \brief Callback function for entity added events
+        /// \param _name   Entity name
+        public: void onAddEntity(const std::string & _name);
+
+        /// \brief Callback function for entity deleted events
+        /// \param _name   Entity name
+        public: void onDeleteEntity(const std::string & _name);
+
         // Private methods
 
         /// \brief Callback function for handling incoming requests
         /// \param _msg  The message
         private: void onRequest(WorldUtilsRequestPtr &_msg);
 
-        /// \brief Removes everything from the world
-        private: void clearWorld();
+        /// \brief Spawns custom objects from SDF strings or registered templates
+        ///
+        /// Name, pose, material and mesh scale in the template are replaced
+        /// by those in the object message, when provided.
+        /// New templates are pre-processed, and the resulting SDF strings
+        /// instantiated and validated, in parallel. Models are then inserted
+        /// in the world sequentially.
+        /// \param _objs    Object messages
+        /// \param _request Request to which spawned entities are added
+        private: void spawnCustom(
+            const std::vector<const gap::msgs::Object *> & _objs,
+            PendingRequest & _request);
+
+        /// \brief Obtains template replacements requested in object message
+        /// \param _obj     Object message
+        /// \return Template replacements
+        private: static SDFOverrides overridesFor(const gap::msgs::Object & _obj);
+
+        /// \brief Moves light in physics and local rendering scene
+        ///
+        /// Should be called from the rendering thread, so that the new pose
+        /// is visible in the next rendered frame.
+        /// \param _name   Light name
+        /// \param _pose   New light pose
+        /// \return Whether the light exists
+        private: bool moveLight(
+            const std::string & _name,
+            const ignition::math::Pose3d & _pose);
+
+        /// \brief Obtains model by name, using model cache
+        /// \param _name   Model name
+        /// \return Pointer to model, null if not found
+        private: physics::ModelPtr modelByName(const std::string & _name);
+
+        /// \brief Resolves pending spawn and removal requests and reports
+        /// completion
+        ///
+        /// Should be called with mutex locked, from the rendering thread
+        private: void checkRequests();
+
+        /// \brief Inserts deferred models once their namesakes are gone
+        ///
+        /// Should be called with mutex locked, from the rendering thread
+        private: void insertDeferred();
+
+        /// \brief Drops deferred models, failing their spawn requests
+        ///
+        /// Should be called with mutex locked
+        private: void dropDeferred();
+
+        /// \brief Reuses parked model spawned from a given template
+        /// \param _tmpl    Template
+        /// \param _obj     Object message
+        /// \return Whether a parked model was reused
+        private: bool unparkModel(
+            const SDFTemplate & _tmpl,
+            const gap::msgs::Object & _obj);
+
+        /// \brief Clears cache of custom SDF templates
+        ///
+        /// Rebuilt templates get new identifiers, so models of evicted ones
+        /// are forgotten.
+        private: void evictTemplates();
+
+        /// \brief Forgets models spawned from discarded templates
+        ///
+        /// Models parked under these identifiers could never be reused and
+        /// are deleted instead. Models still in the world are deleted, rather
+        /// than parked, once removed.
+        /// \param _ids    Identifiers of discarded templates
+        private: void forgetTemplates(
+            const std::unordered_set<unsigned int> & _ids);
+
+        /// \brief Removes entities added since load, and schedules the
+        /// restoration of the remaining ones
+        /// \param _request Request to which removed entities are added
+        private: void resetWorld(PendingRequest & _request);
+
+        /// \brief Restores models and lights present after load to their
+        /// initial state
+        ///
+        /// Should be called with mutex locked, from the rendering thread
+        private: void restoreInitial();
+
+        /// \brief Adds names, poses and types of entities to status response
+        /// \param _filter  Filter for entity names
+        /// \param _msg     Status response message
+        private: void listEntities(
+            const NameFilter & _filter,
+            gap::msgs::WorldUtilsResponse & _msg);
 
-        /// \brief Removes entities matching a given string
-        /// \param match    The string to be matched
-        /// \param is_light Whether to target light objects or not
-        private: void clearMatching(const std::string & match, const bool is_light);
+        /// \brief Removes everything from the world
+        /// \param _request     Request to which removed entities are added
+        private: void clearWorld(PendingRequest & _request);
+
+        /// \brief Removes entities matching any of the given patterns
+        /// \param _patterns    The patterns to be matched
+        /// \param _match       Matching criteria
+        /// \param _is_light    Whether to target light objects or not
+        /// \param _request     Request to which removed entities are added
+        private: void clearMatching(
+            const std::vector<std::string> & _patterns,
+            const int _match,
+            const bool _is_light,
+            PendingRequest & _request);
+
+        /// \brief Requests removal of an entity, without blocking
+        /// \param _name    Entity name
+        private: void deleteEntity(const std::string & _name);
+
+        /// \brief Returns a copy of the unit primitive model of a given type
+        ///
+        /// Unit models are generated once, and then copied and adjusted in
+        /// each spawn, rather than generated and parsed again from strings
+        /// \param _type    Model type, either SPHERE, CYLINDER or BOX
+        /// \return Copy of SDF model element
+        private: sdf::ElementPtr primitive(const int _type);
 
         /// \brief Returns the SDF of a sphere
         /// \param model_name   Model name
@@ -209,9 +461,9 @@ namespace gazebo {
         /// \param radius       Sphere radius
         /// \param position     Sphere position
         /// \param orientation  Sphere orientation
-        /// \return Sphere SDF string
+        /// \return Sphere SDF model element
         /// \deprecated Unused feature, easily replaced by client command
-        private: const std::string genSphere(
+        private: sdf::ElementPtr genSphere(
             const std::string &model_name,
             const double mass,
             const double radius,
@@ -225,9 +477,9 @@ namespace gazebo {
         /// \param length       Cylinder length
         /// \param position     Cylinder position
         /// \param orientation  Cylinder orientation
-        /// \return Cylinder SDF string
+        /// \return Cylinder SDF model element
         /// \deprecated Unused feature, easily replaced by client command
-        private: const std::string genCylinder(
+        private: sdf::ElementPtr genCylinder(
             const std::string &model_name,
             const double mass,
             const double radius,
@@ -241,9 +493,9 @@ namespace gazebo {
         /// \param size         Box size 3D vector
         /// \param position     Box position
         /// \param orientation  Box orientation
-        /// \return Box SDF
+        /// \return Box SDF model element
         /// \deprecated Unused feature, easily replaced by client command
-        private: const std::string genBox(
+        private: sdf::ElementPtr genBox(
             const std::string &model_name,
             const double mass,
             const ignition::math::Vector3d size,
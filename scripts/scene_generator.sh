@@ -12,12 +12,15 @@ output=$4
 
 source setup.sh
 
+# A single server is reused, as each client resets the world on startup,
+# which parks its models for the next client to reuse
+gzserver ./worlds/spawner.world &>/dev/null &
+server=$!
+sleep 2s
+
 for (( i=first; i<scenes; i+=increment))
 do
-    let "final=($i+1)*$increment" 
-    gzserver ./worlds/spawner.world &>/dev/null &
-    sleep 2s
     ./build/bin/scene_example -i "$output/images/" -d "$output/annotations/" -s $increment -n $i
-    pkill -f gz
-    sleep 2s
 done
+
+kill $server
@@ -0,0 +1,119 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file utils/CameraProjector.cc
+    \brief Client-side projection of 3D points to camera image coordinates
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "CameraProjector.hh"
+
+#include <algorithm>
+#include <cmath>
+
+//////////////////////////////////////////////////
+CameraProjector::CameraProjector(const gap::msgs::CameraInfo & _info):
+    width(_info.width()), height(_info.height())
+{
+    if (_info.projection_matrix_size() == 16)
+    {
+        for (int i = 0; i < 16; i++) {
+            projection[i / 4][i % 4] = _info.projection_matrix(i);
+        }
+    }
+    else
+    {
+        // Symmetric perspective projection with square pixels, as set up by
+        // Gazebo cameras; depth row is irrelevant to pixel coordinates
+        const double aspect = static_cast<double>(width) / height;
+        const double focal = 1.0 / tan(0.5 * _info.hfov());
+        const float rows[4][4] = {
+            {static_cast<float>(focal), 0, 0, 0},
+            {0, static_cast<float>(focal * aspect), 0, 0},
+            {0, 0, -1, 0},
+            {0, 0, -1, 0}};
+        std::copy(&rows[0][0], &rows[0][0] + 16, &projection[0][0]);
+    }
+    setPose(ignition::math::Pose3d());
+}
+
+//////////////////////////////////////////////////
+void CameraProjector::setPose(const ignition::math::Pose3d & pose)
+{
+    // View matrix of the OGRE camera, which looks down its -z axis with y
+    // upward, and is rotated accordingly within the Gazebo camera frame
+    const ignition::math::Quaterniond & rot = pose.Rot();
+    const ignition::math::Vector3d axes[3] = {
+        rot.RotateVector(ignition::math::Vector3d(0, -1, 0)),
+        rot.RotateVector(ignition::math::Vector3d(0, 0, 1)),
+        rot.RotateVector(ignition::math::Vector3d(-1, 0, 0))};
+
+    float view[4][4] = {{0}};
+    for (int i = 0; i < 3; i++)
+    {
+        view[i][0] = axes[i].X();
+        view[i][1] = axes[i].Y();
+        view[i][2] = axes[i].Z();
+        view[i][3] = -axes[i].Dot(pose.Pos());
+    }
+    view[3][3] = 1.0f;
+
+    // Depth row is not needed for pixel coordinates
+    const int rows[3] = {0, 1, 3};
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            matrix[i][j] = projection[rows[i]][0] * view[0][j] +
+                projection[rows[i]][1] * view[1][j] +
+                projection[rows[i]][2] * view[2][j] +
+                projection[rows[i]][3] * view[3][j];
+        }
+    }
+}
+
+//////////////////////////////////////////////////
+ignition::math::Vector2i CameraProjector::project(
+    const ignition::math::Vector3d & point) const
+{
+    const float x = point.X(), y = point.Y(), z = point.Z();
+    int u, v;
+    project(&x, &y, &z, 1, &u, &v);
+    return ignition::math::Vector2i(u, v);
+}
+
+//////////////////////////////////////////////////
+void CameraProjector::project(
+    const float *x,
+    const float *y,
+    const float *z,
+    const size_t n,
+    int *u,
+    int *v) const
+{
+    const float (&m)[3][4] = matrix;
+    for (size_t i = 0; i < n; i++)
+    {
+        const float inv_w = 1.0f /
+            (m[2][0] * x[i] + m[2][1] * y[i] + m[2][2] * z[i] + m[2][3]);
+        const float ndc_x =
+            (m[0][0] * x[i] + m[0][1] * y[i] + m[0][2] * z[i] + m[0][3]) * inv_w;
+        const float ndc_y =
+            (m[1][0] * x[i] + m[1][1] * y[i] + m[1][2] * z[i] + m[1][3]) * inv_w;
+        u[i] = ((ndc_x / 2.0) + 0.5) * width;
+        v[i] = (1 - ((ndc_y / 2.0) + 0.5)) * height;
+    }
+}
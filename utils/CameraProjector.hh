@@ -0,0 +1,92 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file utils/CameraProjector.hh
+    \brief Client-side projection of 3D points to camera image coordinates
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _CAMERA_PROJECTOR_HH_
+#define _CAMERA_PROJECTOR_HH_
+
+// Pose and vector types
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector2.hh>
+// Camera intrinsics message
+#include "camera_info.pb.h"
+
+#include <cstddef>
+
+/// \brief Projects world points to pixel coordinates, as a Gazebo camera
+///
+/// Reproduces rendering::Camera::Project from the intrinsics reported by
+/// the CameraUtils INFO request, so clients need not send points to the
+/// plugin for projection.
+/// Arithmetic follows the OGRE camera behind it: points are converted to
+/// single precision and multiplied by the product of projection and view
+/// matrices, then normalized device coordinates are scaled to the image and
+/// truncated towards zero.
+/// As in Camera::Project, points are not clipped, so points behind the
+/// camera yield meaningless coordinates.
+class CameraProjector
+{
+    /// Image width in pixels
+    private: int width;
+    /// Image height in pixels
+    private: int height;
+    /// Projection matrix, row-major
+    private: float projection[4][4];
+    /// Rows x, y and w of projection times view matrix
+    private: float matrix[3][4];
+
+    /// \brief Constructor
+    ///
+    /// Camera starts at the world origin, until setPose is called
+    /// \param _info    Camera image properties and intrinsics
+    public: CameraProjector(const gap::msgs::CameraInfo & _info);
+
+    /// \brief Sets camera world pose
+    /// \param pose     Camera pose, with x axis pointing forward and z upward
+    public: void setPose(const ignition::math::Pose3d & pose);
+
+    /// \brief Projects a single point
+    /// \param point    World point
+    /// \return Pixel coordinates
+    public: ignition::math::Vector2i project(
+        const ignition::math::Vector3d & point) const;
+
+    /// \brief Projects a batch of points
+    ///
+    /// Coordinates are passed as separate arrays, such as the rows of a
+    /// row-major 3xN matrix, so that the loop may be vectorized
+    /// \param x    World x coordinates
+    /// \param y    World y coordinates
+    /// \param z    World z coordinates
+    /// \param n    Number of points
+    /// \param u    Output horizontal pixel coordinates
+    /// \param v    Output vertical pixel coordinates
+    public: void project(
+        const float *x,
+        const float *y,
+        const float *z,
+        const size_t n,
+        int *u,
+        int *v) const;
+};
+
+#endif
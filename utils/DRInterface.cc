@@ -27,6 +27,7 @@
 const char DRInterface::REQUEST_TOPIC[]  = "~/gap/dr";
 const char DRInterface::RESPONSE_TOPIC[] = "~/gap/dr/response";
 const char DRInterface::VISUAL_TOPIC[]   = "~/visual";
+const char DRInterface::VISUAL_UTILS_TOPIC[] = "~/gap/visual_utils";
 const int  DRInterface::POSITION = 0;
 const int  DRInterface::VELOCITY = 1;
 
@@ -43,6 +44,8 @@ DRInterface::DRInterface(
     pub->WaitForConnection();
     pub_visual = node->Advertise<gazebo::msgs::Visual>(VISUAL_TOPIC);
     // pub_visual->WaitForConnection();
+    pub_visual_utils =
+        node->Advertise<VisualUtilsRequest>(VISUAL_UTILS_TOPIC);
     sub = node->Subscribe(res_topic, &DRInterface::onResponse, this);
 
     debugPrintTrace("DRInterface initialized." << std::endl <<
@@ -92,6 +95,13 @@ void DRInterface::publish(gazebo::msgs::Visual & msg, bool blocking)
     pub_visual->Publish(msg);
 }
 
+//////////////////////////////////////////////////
+void DRInterface::publish(VisualUtilsRequest & msg)
+{
+    msg.set_type(VisualUtilsRequest::COLOR);
+    pub_visual_utils->Publish(msg);
+}
+
 //////////////////////////////////////////////////
 void DRInterface::addGravity(DRRequest & msg,
     const ignition::math::Vector3d & gravity)
@@ -270,6 +280,22 @@ void DRInterface::addColors(gazebo::msgs::Visual & msg,
     gazebo::msgs::Set(specular_msg, specular);
 }
 
+//////////////////////////////////////////////////
+void DRInterface::addColors(VisualUtilsRequest & msg,
+    const std::string & visual,
+    const ignition::math::Color & ambient,
+    const ignition::math::Color & diffuse,
+    const ignition::math::Color & emissive,
+    const ignition::math::Color & specular)
+{
+    msg.set_type(VisualUtilsRequest::COLOR);
+    msg.add_targets(visual);
+    gazebo::msgs::Set(msg.add_ambient(), ambient);
+    gazebo::msgs::Set(msg.add_diffuse(), diffuse);
+    gazebo::msgs::Set(msg.add_emissive(), emissive);
+    gazebo::msgs::Set(msg.add_specular(), specular);
+}
+
 /////////////////////////////////////////////////
 void DRInterface::onResponse(DRResponsePtr & _msg)
 {
@@ -43,6 +43,7 @@
 #include "dr_request.pb.h"
 #include "model_cmd.pb.h"
 #include "dr_response.pb.h"
+#include "visual_utils_request.pb.h"
 
 // Debug streams
 #include "debug.hh"
@@ -55,6 +56,9 @@ typedef gap::msgs::DRRequest DRRequest;
 /// Declaration for model command message type
 typedef gap::msgs::ModelCmd ModelCmdMsg;
     
+/// Declaration for visual utils request message type
+typedef gap::msgs::VisualUtilsRequest VisualUtilsRequest;
+
 /// Declaration for response message type
 typedef gap::msgs::DRResponse DRResponse;
 /// Shared pointer declaration for response message type
@@ -80,6 +84,8 @@ class DRInterface
     public: static const char RESPONSE_TOPIC[];
     /// Topic for outgoing visual requests
     public: static const char VISUAL_TOPIC[];
+    /// Topic for outgoing batched visual requests
+    public: static const char VISUAL_UTILS_TOPIC[];
     /// Position controller type
     public: static const int POSITION;
     /// Velocity controller type
@@ -93,6 +99,8 @@ class DRInterface
     private: gazebo::transport::SubscriberPtr sub;
     /// Publisher to the visual topic
     private: gazebo::transport::PublisherPtr pub_visual;
+    /// Publisher to the VisualUtils topic
+    private: gazebo::transport::PublisherPtr pub_visual_utils;
 
     /// Topic for DRPlugin requests
     private: std::string req_topic {REQUEST_TOPIC};
@@ -132,6 +140,13 @@ class DRInterface
     /// \warning Blocking calls not yet implemented for visual messages!
     public: void publish(gazebo::msgs::Visual & msg, bool blocking=false);   
 
+    /// \brief Publishes batched visual request
+    ///
+    /// Handled by VisualUtils plugin, which must be loaded in the world.
+    ///
+    /// \param msg VisualUtils request
+    public: void publish(VisualUtilsRequest & msg);
+
     // Features
 
     /// \brief Updates physics engine gravity
@@ -247,6 +262,25 @@ class DRInterface
         const ignition::math::Color & emissive,
         const ignition::math::Color & specular);
 
+    /// \brief Updates visual color in a batched request
+    ///
+    /// Many visuals may be added to the same request, which is then applied
+    /// in a single rendered frame.
+    /// Setting the request seed samples colors of visuals without any.
+    ///
+    /// \param msg Output VisualUtils request
+    /// \param visual The target visual scoped name
+    /// \param ambient The ambient color
+    /// \param diffuse The diffuse color
+    /// \param emissive The emissive color
+    /// \param specular The specular color
+    public: void addColors(VisualUtilsRequest & msg,
+        const std::string & visual,
+        const ignition::math::Color & ambient,
+        const ignition::math::Color & diffuse,
+        const ignition::math::Color & emissive,
+        const ignition::math::Color & specular);
+
     /// \brief Callback on DRPlugin response
     /// \param _msg Response message
     public: void onResponse(DRResponsePtr & _msg);
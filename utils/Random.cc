@@ -0,0 +1,137 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file utils/Random.cc
+    \brief Counter-based random number generation and sampling
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "Random.hh"
+
+#include <algorithm>
+#include <cmath>
+
+/// Philox multipliers
+#define PHILOX_M0   0xD2511F53
+#define PHILOX_M1   0xCD9E8D57
+/// Philox key increments, Weyl sequence
+#define PHILOX_W0   0x9E3779B9
+#define PHILOX_W1   0xBB67AE85
+/// Number of Philox rounds
+#define PHILOX_ROUNDS   10
+
+//////////////////////////////////////////////////
+Philox::Philox(const uint64_t _seed, const uint64_t _stream)
+{
+    seed(_seed, _stream);
+}
+
+//////////////////////////////////////////////////
+void Philox::seed(const uint64_t _seed, const uint64_t _stream)
+{
+    key[0] = static_cast<uint32_t>(_seed);
+    key[1] = static_cast<uint32_t>(_seed >> 32);
+    counter[0] = counter[1] = 0;
+    counter[2] = static_cast<uint32_t>(_stream);
+    counter[3] = static_cast<uint32_t>(_stream >> 32);
+    index = 4;
+}
+
+//////////////////////////////////////////////////
+Philox Philox::split(const uint64_t _stream) const
+{
+    return Philox(static_cast<uint64_t>(key[1]) << 32 | key[0], _stream);
+}
+
+//////////////////////////////////////////////////
+Philox::result_type Philox::operator()()
+{
+    if (index == 4) {
+        generate();
+    }
+    return block[index++];
+}
+
+//////////////////////////////////////////////////
+void Philox::generate()
+{
+    uint32_t c[4] = {counter[0], counter[1], counter[2], counter[3]};
+    uint32_t k[2] = {key[0], key[1]};
+
+    for (int round = 0; round < PHILOX_ROUNDS; round++)
+    {
+        if (round > 0) {
+            k[0] += PHILOX_W0;
+            k[1] += PHILOX_W1;
+        }
+        const uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c[0];
+        const uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c[2];
+        const uint32_t next[4] = {
+            static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+            static_cast<uint32_t>(p1),
+            static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+            static_cast<uint32_t>(p0)};
+        std::copy(next, next + 4, c);
+    }
+    std::copy(c, c + 4, block);
+    index = 0;
+
+    // Block index is a 64-bit value, stream id is left untouched
+    if (++counter[0] == 0) {
+        ++counter[1];
+    }
+}
+
+//////////////////////////////////////////////////
+int uniformInt(Philox & rng, const int min, const int max)
+{
+    if (max < min) {
+        return min;
+    }
+
+    // Lemire's multiply and reject method; range 0 stands for 2^32
+    const uint32_t range =
+        static_cast<uint32_t>(max) - static_cast<uint32_t>(min) + 1;
+    if (range == 0) {
+        return static_cast<int>(rng());
+    }
+    uint64_t product = static_cast<uint64_t>(rng()) * range;
+    if (static_cast<uint32_t>(product) < range)
+    {
+        // Reject values from the incomplete last interval
+        const uint32_t threshold = -range % range;
+        while (static_cast<uint32_t>(product) < threshold) {
+            product = static_cast<uint64_t>(rng()) * range;
+        }
+    }
+    return static_cast<int>(
+        static_cast<uint32_t>(min) + static_cast<uint32_t>(product >> 32));
+}
+
+//////////////////////////////////////////////////
+double uniformReal(Philox & rng, const double min, const double max)
+{
+    // 27 and 26 bits from consecutive outputs
+    const uint32_t high = rng() >> 5;
+    const uint32_t low = rng() >> 6;
+    const double unit = (high * 67108864.0 + low) / 9007199254740992.0;
+
+    const double value = min + unit * (max - min);
+    // Rounding may reach the upper bound for wide intervals
+    return (value < max || !(max > min))? value : std::nextafter(max, min);
+}
@@ -0,0 +1,115 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*!
+    \file utils/Random.hh
+    \brief Counter-based random number generation and sampling
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _RANDOM_HH_
+#define _RANDOM_HH_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// \brief Philox4x32-10 counter-based random number engine
+///
+/// Each output block is a keyed bijection of a 128-bit counter, so the
+/// engine holds no state besides its position, and any number of
+/// independent streams may be derived from the same seed.
+/// The seed sets the key, whereas the counter is split into a 64-bit stream
+/// id and a 64-bit block index.
+/// Streams are meant to be assigned to units of work, such as scenes, rather
+/// than to threads, so that results do not depend on how work is scheduled.
+/// Meets the UniformRandomBitGenerator requirements.
+class Philox
+{
+    /// Output type
+    public: typedef uint32_t result_type;
+
+    /// Round key
+    private: uint32_t key[2];
+    /// Counter, as block index followed by stream id
+    private: uint32_t counter[4];
+    /// Current output block
+    private: uint32_t block[4];
+    /// Index of next output in current block
+    private: unsigned int index {4};
+
+    /// \brief Constructor
+    /// \param _seed    Seed
+    /// \param _stream  Stream id
+    public: Philox(const uint64_t _seed=0, const uint64_t _stream=0);
+
+    /// \brief Restarts engine at the beginning of a stream
+    /// \param _seed    Seed
+    /// \param _stream  Stream id
+    public: void seed(const uint64_t _seed, const uint64_t _stream=0);
+
+    /// \brief Creates engine for another stream with the same seed
+    /// \param _stream  Stream id
+    /// \return New engine, at the beginning of the stream
+    public: Philox split(const uint64_t _stream) const;
+
+    /// \brief Generates next random value
+    /// \return Uniformly distributed 32-bit value
+    public: result_type operator()();
+
+    /// \brief Smallest possible output
+    /// \return Zero
+    public: static constexpr result_type min() { return 0; }
+
+    /// \brief Largest possible output
+    /// \return Maximum 32-bit value
+    public: static constexpr result_type max() { return UINT32_MAX; }
+
+    /// \brief Computes output block of current counter and increments it
+    private: void generate();
+};
+
+/// \brief Samples integer from uniform distribution, without bias
+/// \param rng  Random number engine
+/// \param min  Interval lower bound
+/// \param max  Interval upper bound, inclusive
+/// \return Random integer in [min, max], or min if max < min
+int uniformInt(Philox & rng, const int min, const int max);
+
+/// \brief Samples real number from uniform distribution
+///
+/// Uses 53 random bits, the full precision of a double in [0, 1)
+/// \param rng  Random number engine
+/// \param min  Interval lower bound
+/// \param max  Interval upper bound, exclusive
+/// \return Random double in [min, max)
+double uniformReal(Philox & rng, const double min, const double max);
+
+/// \brief Randomly shuffles a vector
+///
+/// Unlike std::shuffle, the result does not depend on the standard library
+/// \param rng      Random number engine
+/// \param vector   Vector to shuffle in place
+template <typename T>
+void shuffle(Philox & rng, std::vector<T> & vector)
+{
+    for (int i = static_cast<int>(vector.size()) - 1; i > 0; i--) {
+        std::swap(vector[i], vector[uniformInt(rng, 0, i)]);
+    }
+}
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file utils/Synchronizer.cc
+    \brief Synchronization of client processes with plugin responses
+
+    \author João Borrego : jsbruglie
+*/
+
+#include "Synchronizer.hh"
+
+#include <chrono>
+
+const unsigned int Synchronizer::ANY = 0;
+
+//////////////////////////////////////////////////
+unsigned int Synchronizer::nextId()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // Skip wildcard on wrap around
+    if (++last_id == ANY) {
+        ++last_id;
+    }
+    return last_id;
+}
+
+//////////////////////////////////////////////////
+void Synchronizer::notify(const int event, const unsigned int id)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        posted.emplace(event, id);
+    }
+    cond_var.notify_all();
+}
+
+//////////////////////////////////////////////////
+bool Synchronizer::wait(
+    const int event,
+    const unsigned int id,
+    const double timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto ready = [&] { return consume(event, id); };
+
+    if (timeout < 0) {
+        cond_var.wait(lock, ready);
+        return true;
+    }
+    return cond_var.wait_for(lock,
+        std::chrono::duration<double>(timeout), ready);
+}
+
+//////////////////////////////////////////////////
+void Synchronizer::clear(const int event)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    posted.erase(
+        posted.lower_bound(std::make_pair(event, 0u)),
+        posted.upper_bound(std::make_pair(event, ~0u)));
+}
+
+//////////////////////////////////////////////////
+bool Synchronizer::consume(const int event, const unsigned int id)
+{
+    auto it = (id == ANY)?
+        posted.lower_bound(std::make_pair(event, 0u)) :
+        posted.find(std::make_pair(event, id));
+    if (it == posted.end() || it->first != event) {
+        return false;
+    }
+    posted.erase(it);
+    return true;
+}
@@ -0,0 +1,89 @@
+/*
+ *  Copyright (C) 2018 João Borrego
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *      
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*!
+    \file utils/Synchronizer.hh
+    \brief Synchronization of client processes with plugin responses
+
+    \author João Borrego : jsbruglie
+*/
+
+#ifndef _SYNCHRONIZER_HH_
+#define _SYNCHRONIZER_HH_
+
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <utility>
+
+/// \brief Blocks a client until plugin responses arrive
+///
+/// Response callbacks run in transport threads and call notify() with an
+/// event identifier, chosen by the client, and the id echoed by the plugin,
+/// if any. A thread blocked in wait() for that event is woken up immediately.
+/// Notifications are kept until consumed by a matching wait(), so responses
+/// that arrive before the client starts waiting are not lost.
+/// Repeated notifications of the same event and id are merged.
+class Synchronizer
+{
+    /// Wildcard request id, matching any notification of an event
+    public: static const unsigned int ANY;
+
+    /// Pending notifications, as (event, request id) pairs
+    private: std::set<std::pair<int, unsigned int>> posted;
+    /// Counter for request id generation
+    private: unsigned int last_id {0};
+    /// Mutex for exclusive threaded access
+    private: std::mutex mutex;
+    /// Condition variable signalled on every notification
+    private: std::condition_variable cond_var;
+
+    /// \brief Generates a new request id
+    /// \return Non-zero request id, unique for this synchronizer
+    public: unsigned int nextId();
+
+    /// \brief Signals the occurrence of an event
+    /// \param event    Event identifier
+    /// \param id       Request id the event refers to
+    public: void notify(const int event, const unsigned int id=ANY);
+
+    /// \brief Blocks until an event is signalled, and consumes it
+    /// \param event    Event identifier
+    /// \param id       Request id to wait for, or ANY
+    /// \param timeout  Maximum waiting time in seconds, negative waits forever
+    /// \return True if event occurred, false on timeout
+    public: bool wait(
+        const int event,
+        const unsigned int id=ANY,
+        const double timeout=-1.0);
+
+    /// \brief Discards pending notifications of an event
+    ///
+    /// Useful before issuing a request, so that stale responses from
+    /// previous requests are not mistaken for its reply
+    /// \param event    Event identifier
+    public: void clear(const int event);
+
+    /// \brief Finds and removes a matching notification
+    /// \warning Caller must hold the mutex
+    /// \param event    Event identifier
+    /// \param id       Request id, or ANY
+    /// \return True if a matching notification was found
+    private: bool consume(const int event, const unsigned int id);
+};
+
+#endif